@@ -1,12 +1,19 @@
 #include "BluedHdf5Converter.h"
 #include "AsyncDataQueue.h"
 #include "BluedInputSource.h"
+#include "BluedHdf5TimeIndex.h"
 #include "H5Cpp.h"
+#include <thread>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <exception>
 
 using namespace H5;
 
 void BluedHdf5Converter::convertToHdf5(const std::string &input_file, const std::string &output_file) {
     BluedInputSource input;
+    input.number_of_parser_threads = std::max(std::thread::hardware_concurrency(), 1u);
     input.readWholeLocation(input_file);
 
     try {
@@ -20,35 +27,62 @@ void BluedHdf5Converter::convertToHdf5(const std::string &input_file, const std:
 
 void BluedHdf5Converter::writeData(BluedDataManager &mgr) {
     hsize_t offset[2] = {0, 0};
+    hsize_t reserved_rows = this->dims[0];
 
+    std::vector<BluedDataPoint> buffer(std::max<hsize_t>(this->rows_per_write, 1));
 
-    const int buffer_size = 1000;
-    BluedDataPoint buffer[buffer_size];
-
+    // pairs of row and x_value, see BluedHdf5TimeIndex
+    std::vector<double> time_index;
+    DataSpace fspace = dataset.getSpace();
     int count = 0;
     while (true) {
-        BluedDataPoint *buffer_end = mgr.popDataPoints(buffer, &buffer[buffer_size]);
-        hsize_t buffer_len =static_cast<hsize_t>(buffer_end - buffer);
+        auto buffer_end = mgr.popDataPoints(buffer.begin(), buffer.end());
+        hsize_t buffer_len = static_cast<hsize_t>(buffer_end - buffer.begin());
         if (buffer_len == 0) {
             break;
         }
-        hsize_t size[2] = {offset[0] + buffer_len, this->dims[1]};
-        dataset.extend(size);
+        if (offset[0] + buffer_len > reserved_rows) {
+            // grow geometrically, the rows that are not written are trimmed at the end
+            reserved_rows = std::max(offset[0] + buffer_len, 2 * reserved_rows);
+            hsize_t size[2] = {reserved_rows, this->dims[1]};
+            dataset.extend(size);
+            fspace = dataset.getSpace();
+        }
         hsize_t hyper_slab_dimensions[2] = {buffer_len, this->dims[1]};
         DataSpace mspace(rank, hyper_slab_dimensions);
 
-
-        DataSpace fspace = dataset.getSpace();
-
         fspace.selectHyperslab(H5S_SELECT_SET, hyper_slab_dimensions, offset);
-        dataset.write(reinterpret_cast<const void*>(buffer), PredType::NATIVE_FLOAT, mspace, fspace);
+        dataset.write(reinterpret_cast<const void*>(buffer.data()), PredType::NATIVE_FLOAT, mspace, fspace);
+        const hsize_t interval = BluedHdf5TimeIndex::time_index_interval;
+        for (hsize_t row = (offset[0] + interval - 1) / interval * interval; row < offset[0] + buffer_len; row += interval) {
+            time_index.push_back(static_cast<double>(row));
+            time_index.push_back(buffer[row - offset[0]].x_value);
+        }
         offset[0] += buffer_len;
         ++count;
-        if(count % 1000 == 0) {
+        if(count % 16 == 0) {
             std::cout << "Converted elements: " << offset[0]  << std::endl;
         }
     }
+    if (offset[0] != reserved_rows) {
+        hsize_t size[2] = {offset[0], this->dims[1]};
+        if (H5Dset_extent(dataset.getId(), size) < 0) {
+            std::cerr << "Could not trim the data set to " << offset[0] << " rows" << std::endl;
+            throw std::exception();
+        }
+    }
     std::cout << "Total converted elements: " << offset[0]  << std::endl;
+    this->writeTimeIndex(time_index);
+}
+
+void BluedHdf5Converter::writeTimeIndex(const std::vector<double> &time_index) {
+    hsize_t index_dims[rank] = {time_index.size() / 2, 2};
+    DataSpace index_space(rank, index_dims);
+    DataSet index_dataset = file.createDataSet(BluedHdf5TimeIndex::indexDataSetName(), PredType::NATIVE_DOUBLE,
+                                               index_space);
+    if (!time_index.empty()) {
+        index_dataset.write(time_index.data(), PredType::NATIVE_DOUBLE);
+    }
 }
 
 void BluedHdf5Converter::createNewDataSpace(const std::string &output_file) {
@@ -64,10 +98,17 @@ void BluedHdf5Converter::createNewDataSpace(const std::string &output_file) {
 
     hsize_t max_dims[rank] = {H5S_UNLIMITED, ncols};
 
+    this->dims[0] = this->expected_rows;
     this->file_data_space = DataSpace(rank, this->dims, max_dims);
     DSetCreatPropList cparms;
-    hsize_t chunk_dims[rank] = {chunk_size, ncols};
+    hsize_t chunk_dims[rank] = {std::max<hsize_t>(this->chunk_rows, 1), ncols};
     cparms.setChunk(rank, chunk_dims);
+    if (this->shuffle) {
+        cparms.setShuffle();
+    }
+    if (this->compression_level > 0) {
+        cparms.setDeflate(std::min(this->compression_level, 9u));
+    }
 
     this->dataset = file.createDataSet(DATASET_NAME, datatype, file_data_space, cparms);
 }
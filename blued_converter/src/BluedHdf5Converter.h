@@ -2,6 +2,7 @@
 #define BLUEDHDF5CONVERTER_H
 
 #include <string>
+#include <vector>
 #include "H5Cpp.h"
 #include "AsyncDataQueue.h"
 #include "BluedInputSource.h"
@@ -10,13 +11,37 @@ class BluedHdf5Converter
 {
 public:
     void convertToHdf5(const std::string& input_file, const std::string& output_file);
+
+public:
+    /**
+     * @brief Number of rows per chunk of the data set. Chunks are the unit of compression and of reading.
+     */
+    hsize_t chunk_rows = 1 << 15;
+    /**
+     * @brief Deflate level from 0 to 9. With 0 the data is stored uncompressed.
+     */
+    unsigned int compression_level = 4;
+    /**
+     * @brief Reorders the bytes of the floats before deflating them, which compresses the slowly changing values much better.
+     */
+    bool shuffle = true;
+    /**
+     * @brief Number of rows that are written to the file at once.
+     */
+    hsize_t rows_per_write = 1 << 16;
+    /**
+     * @brief If the number of rows is known, the data set is created with this size. Otherwise it grows geometrically and
+     * is trimmed to the rows written at the end.
+     */
+    hsize_t expected_rows = 0;
+
 private:
     void createNewDataSpace(const std::string& output_file);
     void writeData(BluedDataManager& mgr);
+    void writeTimeIndex(const std::vector<double>& time_index);
 private:
     static const int rank = 2;
     static const int ncols = 4;
-    static const int chunk_size = 240;
     hsize_t dims[rank] = {0, ncols};
 
     
@@ -11,10 +11,21 @@
 
 int main(int argc, char **argv) {
     if(argc < 3) {
-        std::cout << "usage: blued_converter <directory to files> <outfile>\n";
+        std::cout << "usage: blued_converter <directory to files> <outfile> [<chunk rows> [<compression level> [<expected rows>]]]\n";
+        std::cout << "The compression level goes from 0 (uncompressed) to 9.\n";
+        std::cout << "With the expected number of rows the data set is created with its final size instead of growing.\n";
         return -1;
     }
     BluedHdf5Converter converter;
+    if (argc >= 4) {
+        converter.chunk_rows = std::stoul(argv[3]);
+    }
+    if (argc >= 5) {
+        converter.compression_level = std::stoul(argv[4]);
+    }
+    if (argc >= 6) {
+        converter.expected_rows = std::stoull(argv[5]);
+    }
     converter.convertToHdf5(std::string(argv[1]), std::string(argv[2]));
     return 0;
 }
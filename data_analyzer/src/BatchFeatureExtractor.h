@@ -0,0 +1,158 @@
+#ifndef SMART_SCREEN_BATCHFEATUREEXTRACTOR_H
+#define SMART_SCREEN_BATCHFEATUREEXTRACTOR_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include "EventFeatures.h"
+#include "FeatureExtractor.h"
+
+/**
+ * @brief Extracts the features of many events on a pool of worker threads.
+ *
+ * Every worker owns a FeatureExtractor and with it its own FFT workspace, so the workers never share state. The features are
+ * returned in the order of the events. extractFeatures blocks until the whole batch is done and must only be called from one
+ * thread at a time.
+ */
+class BatchFeatureExtractor {
+public:
+    explicit BatchFeatureExtractor(unsigned int number_of_threads = std::thread::hardware_concurrency());
+
+    ~BatchFeatureExtractor();
+
+    BatchFeatureExtractor(const BatchFeatureExtractor &) = delete;
+
+    BatchFeatureExtractor &operator=(const BatchFeatureExtractor &) = delete;
+
+    void setConfig(const ClassificationConfig &config);
+
+    /**
+     * @brief Extracts the features of the events in [begin, end). IteratorType has to be a random access iterator.
+     */
+    template<typename IteratorType> std::vector<EventFeatures> extractFeatures(IteratorType begin, IteratorType end);
+
+    unsigned int numberOfThreads() const {
+        return static_cast<unsigned int>(this->workers.size());
+    }
+
+private:
+    typedef std::function<void(FeatureExtractor &, unsigned long)> JobType;
+
+    void work(unsigned int worker_id);
+
+    void runJob(unsigned long number_of_tasks, const JobType &task);
+
+private:
+    std::vector<FeatureExtractor> extractors;
+    std::vector<std::thread> workers;
+
+    std::mutex job_mutex;
+    std::condition_variable job_available;
+    std::condition_variable job_done;
+    const JobType *job = nullptr;
+    unsigned long job_size = 0;
+    unsigned long job_generation = 0;
+    unsigned int busy_workers = 0;
+    std::exception_ptr job_exception;
+    bool stop = false;
+
+    std::atomic<unsigned long> next_task{0};
+};
+
+inline BatchFeatureExtractor::BatchFeatureExtractor(unsigned int number_of_threads) {
+    number_of_threads = std::max(number_of_threads, 1u);
+    this->extractors.resize(number_of_threads);
+    for (unsigned int i = 0; i < number_of_threads; ++i) {
+        this->workers.emplace_back(&BatchFeatureExtractor::work, this, i);
+    }
+}
+
+inline BatchFeatureExtractor::~BatchFeatureExtractor() {
+    {
+        std::lock_guard<std::mutex> lock(this->job_mutex);
+        this->stop = true;
+    }
+    this->job_available.notify_all();
+    for (auto &worker: this->workers) {
+        worker.join();
+    }
+}
+
+inline void BatchFeatureExtractor::setConfig(const ClassificationConfig &config) {
+    std::lock_guard<std::mutex> lock(this->job_mutex);
+    for (auto &extractor: this->extractors) {
+        extractor.setConfig(config);
+    }
+}
+
+template<typename IteratorType> std::vector<EventFeatures>
+BatchFeatureExtractor::extractFeatures(IteratorType begin, IteratorType end) {
+    std::vector<EventFeatures> result(end - begin);
+    this->runJob(result.size(), [&result, begin](FeatureExtractor &extractor, unsigned long index) {
+        result[index] = extractor.extractFeatures(*(begin + index));
+    });
+    return result;
+}
+
+inline void BatchFeatureExtractor::runJob(unsigned long number_of_tasks, const JobType &task) {
+    if (number_of_tasks == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(this->job_mutex);
+    this->job = &task;
+    this->job_size = number_of_tasks;
+    this->next_task = 0;
+    this->busy_workers = static_cast<unsigned int>(this->workers.size());
+    this->job_exception = nullptr;
+    ++this->job_generation;
+    this->job_available.notify_all();
+
+    this->job_done.wait(lock, [this]() {
+        return this->busy_workers == 0;
+    });
+    this->job = nullptr;
+    if (this->job_exception) {
+        std::rethrow_exception(this->job_exception);
+    }
+}
+
+inline void BatchFeatureExtractor::work(unsigned int worker_id) {
+    unsigned long finished_generation = 0;
+    while (true) {
+        std::unique_lock<std::mutex> lock(this->job_mutex);
+        this->job_available.wait(lock, [this, finished_generation]() {
+            return this->stop || this->job_generation != finished_generation;
+        });
+        if (this->stop) {
+            return;
+        }
+        finished_generation = this->job_generation;
+        const JobType &task = *this->job;
+        const unsigned long number_of_tasks = this->job_size;
+        lock.unlock();
+
+        try {
+            for (unsigned long index = this->next_task++; index < number_of_tasks; index = this->next_task++) {
+                task(this->extractors[worker_id], index);
+            }
+        } catch (...) {
+            lock.lock();
+            this->job_exception = std::current_exception();
+            // let the other workers run out of tasks
+            this->next_task = number_of_tasks;
+            lock.unlock();
+        }
+
+        lock.lock();
+        if (--this->busy_workers == 0) {
+            this->job_done.notify_one();
+        }
+    }
+}
+
+#endif //SMART_SCREEN_BATCHFEATUREEXTRACTOR_H
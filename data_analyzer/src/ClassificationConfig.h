@@ -7,12 +7,24 @@ namespace NormalizationMode {
         Standardize
     };
 }
+
+namespace SpectrumMode {
+    enum SpectrumMode{
+        // real input FFT of all data points
+        FastFourierTransform,
+        // Goertzel evaluation of only the bins around the base frequency and the harmonics
+        SparseFourierTransform
+    };
+}
 class ClassificationConfig {
 public:
     int number_of_rms = 20;
     NormalizationMode::NormalizationMode normalization_mode = NormalizationMode::Standardize;
     unsigned long number_of_harmonics = 10;
     unsigned long harmonics_search_radius = 5;
+    SpectrumMode::SpectrumMode spectrum_mode = SpectrumMode::FastFourierTransform;
+    // number of threads that extract features of pushed events. The events are still classified one at a time, in push order
+    unsigned int number_of_classification_threads = 1;
 
 
 };
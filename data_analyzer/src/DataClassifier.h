@@ -2,6 +2,9 @@
 #define SMART_SCREEN_DATAANALYZER_H
 
 #include <vector>
+#include <deque>
+#include <atomic>
+#include <iterator>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
@@ -10,6 +13,7 @@
 #include "EventLabelManager.h"
 #include "ClassificationConfig.h"
 #include "FeatureExtractor.h"
+#include "IncrementalNearestNeighbourIndex.h"
 #include <nabo/nabo.h>
 #include <boost/optional/optional_io.hpp>
 
@@ -32,6 +36,13 @@ public:
 
     void pushEvent(const Event<DataPointType> &e);
 
+    /**
+     * @brief Adds the features of an event whose features were already extracted, e.g. by a BatchFeatureExtractor.
+     *
+     * The features are labeled or classified right away in the calling thread, like the worker thread does with pushed events.
+     */
+    void processEventFeatures(const EventFeatures &features);
+
     void classifyOneEvent(const EventFeatures &e);
 
     void addLabel(const LabelTimePair &label);
@@ -40,8 +51,11 @@ public:
     void addLabels(const std::vector<LabelTimePair> &labels);
 
     void join() {
-        if (this->runner.joinable())
-            this->runner.join();
+        for (auto &runner: this->runners) {
+            if (runner.joinable())
+                runner.join();
+        }
+        this->runners.clear();
     }
 
     ~DataClassifier() { this->stopAnalyzing(); }
@@ -58,9 +72,11 @@ public:
 
 
 private:
-    void run();
+    void run(unsigned int worker_id);
 
-    void processOneEvent(const Event<DataPointType> &features);
+    void processOneEvent(const Event<DataPointType> &event, FeatureExtractor &feature_extractor, unsigned long ticket);
+
+    void processFeatures(const EventFeatures &features);
 
     Eigen::VectorXf convertToEigenVector(const EventFeatures &features);
 
@@ -72,51 +88,60 @@ private:
 
     bool featureVectorIsInRange(const Eigen::VectorXf &vec);
 
-    void generateNormalizationVectors(const Eigen::MatrixXf &matrix);
+    void generateNormalizationVectors();
 
-    void generateRescaleNormalizationVectors(const Eigen::MatrixXf &matrix);
+    void generateRescaleNormalizationVectors();
 
-    void generateStandardizeNormalizationVectors(const Eigen::MatrixXf &matrix);
+    void generateStandardizeNormalizationVectors();
 
-    void generateFirstNormalizationVectors(const Eigen::MatrixXf &matrix);
+    void generateFirstNormalizationVectors();
 
-    Eigen::MatrixXf generateMatrixFromLabeledEvents();
+    void addToFeatureStatistics(const Eigen::VectorXf &vec);
 
-    std::vector<DataFeatureType> eigenToStdVector(const Eigen::VectorXf &vec) {
-        std::vector<DataClassifier::DataFeatureType> result;
-        result.reserve(vec.size());
-        for (int i = 0; i < vec.size(); ++i) {
-            result.push_back(vec(i));
-        }
-        return result;
+    void recalculateFeatureStatistics();
 
-    }
+    Eigen::MatrixXf generateMatrixFromLabeledEvents();
 
+    static Eigen::Map<const Eigen::VectorXf> featureVectorMap(const EventFeatures &features) {
+        return Eigen::Map<const Eigen::VectorXf>(features.feature_vector.data(), features.feature_vector.size());
+    }
 
-    Eigen::VectorXf generateMaxVector(const Eigen::MatrixXf &matrix);
 
-    Eigen::VectorXf generateMinVector(const Eigen::MatrixXf &matrix);
+    Eigen::VectorXf generateMaxVector();
 
-    void pushToMatrix(const Eigen::VectorXf &vec);
+    Eigen::VectorXf generateMinVector();
 
     Eigen::VectorXf normalizeEvent(Eigen::VectorXf vec);
 
-    void normalizeMatrix(Eigen::MatrixXf &matrix);
-
 
 private:
     EventLabelManager<DataPointType> event_label_manager;
     ClassificationConfig classification_config;
-    FeatureExtractor feature_extractor;
-    std::thread runner;
-    bool continue_analyzing = true;
+    std::vector<FeatureExtractor> feature_extractors;
+    std::vector<std::thread> runners;
+    unsigned int number_of_workers = 1;
+    std::atomic<bool> continue_analyzing{true};
+
+    // guards the pending events, the event tickets and the number of events in progress
     std::mutex events_mutex;
     std::condition_variable events_empty_variable;
-    std::vector<Event<DataPointType>> events;
-    Eigen::MatrixXf labeled_matrix;
+    std::condition_variable events_processed_variable;
+    std::deque<Event<DataPointType>> events;
+    unsigned long next_event_ticket = 0;
+    unsigned long events_in_progress = 0;
+
+    // guards the labels, the matrix and the search index. The events are classified in the order of their tickets
+    std::mutex classifier_mutex;
+    std::condition_variable classification_turn_variable;
+    unsigned long next_classification_ticket = 0;
     Eigen::VectorXf normalization_mul_vector;
     Eigen::VectorXf normalization_add_vector;
-    std::unique_ptr<Nabo::NNSearchF> nns;
+    IncrementalNearestNeighbourIndex nearest_neighbour_index;
+
+    // running mean and sum of squared deviations (Welford) of the features of the labeled events
+    unsigned long feature_statistics_count = 0;
+    Eigen::VectorXd feature_mean;
+    Eigen::VectorXd feature_squared_deviations;
 
 
 };
@@ -131,11 +156,30 @@ template<typename DataPointType> void DataClassifier<DataPointType>::pushEvent(c
 }
 
 template<typename DataPointType> void
-DataClassifier<DataPointType>::processOneEvent(const Event<DataPointType> &event) {
+DataClassifier<DataPointType>::processOneEvent(const Event<DataPointType> &event, FeatureExtractor &feature_extractor,
+                                               unsigned long ticket) {
     EventFeatures features = feature_extractor.extractFeatures(event);
 
+    std::unique_lock<std::mutex> classifier_lock(this->classifier_mutex);
+    this->classification_turn_variable.wait(classifier_lock, [this, ticket]() {
+        return this->next_classification_ticket == ticket || !this->continue_analyzing;
+    });
+    if (!this->continue_analyzing) {
+        return;
+    }
+    this->processFeatures(features);
+    ++this->next_classification_ticket;
+    this->classification_turn_variable.notify_all();
+}
 
+template<typename DataPointType> void
+DataClassifier<DataPointType>::processEventFeatures(const EventFeatures &features) {
+    std::lock_guard<std::mutex> classifier_lock(this->classifier_mutex);
+    this->processFeatures(features);
+}
 
+template<typename DataPointType> void
+DataClassifier<DataPointType>::processFeatures(const EventFeatures &features) {
     if (event_label_manager.findLabelAndAddEvent(features)) {
         this->addEventToNormalizedMatrix(features);
     } else {
@@ -161,16 +205,17 @@ template<typename DataPointType> void DataClassifier<DataPointType>::classifyOne
 
     // Look for the 5 nearest neighbours of each query point,
     // We do not want approximations but we want to sort by the distance,
-    indices.resize(k);
-    dists2.resize(k);
     auto vect = this->convertToEigenVector(features);
-    nns->knn(normalizeEvent(vect), indices, dists2, k);
+    const unsigned long neighbours_found = nearest_neighbour_index.knn(normalizeEvent(vect), indices, dists2, k);
+    if (neighbours_found == 0) {
+        return;
+    }
 #ifdef DEBUG_OUTPUT
     std::cout << "The labels of the closest neighbors are: ";
 #endif
 
     std::map<EventMetaData::LabelType, int> labels;
-    for (int i = 0; i < k; ++i) {
+    for (int i = 0; i < neighbours_found; ++i) {
         labels[*event_label_manager.labeled_events[indices(i)].event_meta_data.label]++;
 #ifdef DEBUG_OUTPUT
         std::cout << event_label_manager.labeled_events[indices(i)].event_meta_data.label;
@@ -201,8 +246,16 @@ DataClassifier<DataPointType>::startClassification(const std::string &label_loca
 }
 
 template<typename DataPointType> void DataClassifier<DataPointType>::stopAnalyzing() {
-    this->continue_analyzing = false;
+    {
+        std::lock_guard<std::mutex> events_lock(this->events_mutex);
+        this->continue_analyzing = false;
+    }
     this->events_empty_variable.notify_all();
+    {
+        // taking the lock makes sure no worker misses the notification between its check and its wait
+        std::lock_guard<std::mutex> classifier_lock(this->classifier_mutex);
+    }
+    this->classification_turn_variable.notify_all();
     this->join();
 
 }
@@ -210,8 +263,8 @@ template<typename DataPointType> void DataClassifier<DataPointType>::stopAnalyzi
 template<typename DataPointType> void DataClassifier<DataPointType>::stopAnalyzingWhenDone() {
     {
         std::unique_lock<std::mutex> events_lock(this->events_mutex);
-        this->events_empty_variable.wait(events_lock, [this]() {
-            return this->events.empty();
+        this->events_processed_variable.wait(events_lock, [this]() {
+            return (this->events.empty() && this->events_in_progress == 0) || !this->continue_analyzing;
         });
     }
 
@@ -237,12 +290,18 @@ DataClassifier<DataPointType>::addEventToNormalizedMatrix(const EventFeatures &f
 
 
     Eigen::VectorXf feature_vec = convertToEigenVector(features);
+    addToFeatureStatistics(feature_vec);
     if (needToRegenerateMatrixForVector(feature_vec)) {
 
         regenerateMatrix();
 
     } else {
-        pushToMatrix(normalizeEvent(feature_vec));
+        // the normalization of the index is only updated with the next rebuild, which is due after a fixed fraction of
+        // new events, so the rebuild cost is amortized over the inserts
+        nearest_neighbour_index.insert(normalizeEvent(feature_vec));
+        if (nearest_neighbour_index.needsRebuild()) {
+            regenerateMatrix();
+        }
     }
 
 
@@ -265,24 +324,24 @@ DataClassifier<DataPointType>::featureVectorIsInRange(const Eigen::VectorXf &vec
 }
 
 template<typename DataPointType> void
-DataClassifier<DataPointType>::generateNormalizationVectors(const Eigen::MatrixXf &matrix) {
+DataClassifier<DataPointType>::generateNormalizationVectors() {
     if (this->event_label_manager.labeled_events.size() == 1) {
-        generateFirstNormalizationVectors(matrix);
+        generateFirstNormalizationVectors();
     } else if (classification_config.normalization_mode == NormalizationMode::Rescale) {
-        generateRescaleNormalizationVectors(matrix);
+        generateRescaleNormalizationVectors();
     } else {
-        generateStandardizeNormalizationVectors(matrix);
+        generateStandardizeNormalizationVectors();
     }
 
 }
 
 template<typename DataPointType> void
-DataClassifier<DataPointType>::generateRescaleNormalizationVectors(const Eigen::MatrixXf &matrix) {
+DataClassifier<DataPointType>::generateRescaleNormalizationVectors() {
 
     Eigen::VectorXf max_vector;
     Eigen::VectorXf min_vector;
-    min_vector = generateMinVector(matrix);
-    max_vector = generateMaxVector(matrix);
+    min_vector = generateMinVector();
+    max_vector = generateMaxVector();
 
 
     for (long i = 0; i < normalization_mul_vector.size(); ++i) {
@@ -295,24 +354,25 @@ DataClassifier<DataPointType>::generateRescaleNormalizationVectors(const Eigen::
 }
 
 template<typename DataPointType> void
-DataClassifier<DataPointType>::generateStandardizeNormalizationVectors(const Eigen::MatrixXf &matrix) {
-    if (matrix.cols() < 2) {
+DataClassifier<DataPointType>::generateStandardizeNormalizationVectors() {
+    if (this->event_label_manager.labeled_events.size() < 2) {
         return;
     }
+    if (this->feature_statistics_count != this->event_label_manager.labeled_events.size()) {
+        this->recalculateFeatureStatistics();
+    }
 
-    normalization_mul_vector.resize(matrix.rows());
-    normalization_add_vector.resize(matrix.rows());
-    const float *data = matrix.row(0).data();
+    long rows = this->feature_mean.size();
+    normalization_mul_vector.resize(rows);
+    normalization_add_vector.resize(rows);
     const float min_deviation = 0.001;
 
 
-    for (long i = 0; i < matrix.rows(); ++i) {
-        auto row_vector = eigenToStdVector(matrix.row(i));
-
-        FeatureExtractor::FeatureType mean = Algorithms::mean(row_vector.begin(), row_vector.end());
-
+    for (long i = 0; i < rows; ++i) {
+        FeatureExtractor::FeatureType mean = static_cast<FeatureExtractor::FeatureType>(this->feature_mean(i));
 
-        FeatureExtractor::FeatureType variance = Algorithms::variance(row_vector.begin(), row_vector.end());
+        // like Algorithms::variance this is the sum of the squared deviations
+        FeatureExtractor::FeatureType variance = static_cast<FeatureExtractor::FeatureType>(this->feature_squared_deviations(i));
 
         FeatureExtractor::FeatureType deviation = std::max(min_deviation, std::sqrt(variance));
 
@@ -321,57 +381,63 @@ DataClassifier<DataPointType>::generateStandardizeNormalizationVectors(const Eig
     }
 }
 
+template<typename DataPointType> void
+DataClassifier<DataPointType>::addToFeatureStatistics(const Eigen::VectorXf &vec) {
+    if (this->feature_statistics_count == 0 || this->feature_mean.size() != vec.size()) {
+        this->feature_statistics_count = 0;
+        this->feature_mean = Eigen::VectorXd::Zero(vec.size());
+        this->feature_squared_deviations = Eigen::VectorXd::Zero(vec.size());
+    }
+    ++this->feature_statistics_count;
+    Eigen::VectorXd value = vec.cast<double>();
+    Eigen::VectorXd delta = value - this->feature_mean;
+    this->feature_mean += delta / static_cast<double>(this->feature_statistics_count);
+    this->feature_squared_deviations += delta.cwiseProduct(value - this->feature_mean);
+}
+
+template<typename DataPointType> void DataClassifier<DataPointType>::recalculateFeatureStatistics() {
+    this->feature_statistics_count = 0;
+    for (const auto &labeled_event: this->event_label_manager.labeled_events) {
+        this->addToFeatureStatistics(featureVectorMap(labeled_event));
+    }
+}
+
 template<typename DataPointType> Eigen::VectorXf
-DataClassifier<DataPointType>::generateMaxVector(const Eigen::MatrixXf &matrix) {
-    Eigen::VectorXf max = matrix.col(0);
-    for (long i = 1; i < matrix.cols(); ++i) {
-        for (long j = 0; j < matrix.rows(); ++j) {
-            if (matrix(j, i) > max(j)) {
-                max(j) = matrix(j, i);
-            }
-        }
+DataClassifier<DataPointType>::generateMaxVector() {
+    const auto &labeled_events = this->event_label_manager.labeled_events;
+    Eigen::VectorXf max = featureVectorMap(labeled_events.front());
+    for (std::size_t i = 1; i < labeled_events.size(); ++i) {
+        max = max.cwiseMax(featureVectorMap(labeled_events[i]));
     }
     return max;
 }
 
 
 template<typename DataPointType> Eigen::VectorXf
-DataClassifier<DataPointType>::generateMinVector(const Eigen::MatrixXf &matrix) {
-    Eigen::VectorXf min = matrix.col(0);
-    for (long i = 1; i < matrix.cols(); ++i) {
-        for (long j = 0; j < matrix.rows(); ++j) {
-            if (matrix(j, i) < min(j)) {
-                min(j) = matrix(j, i);
-            }
-        }
+DataClassifier<DataPointType>::generateMinVector() {
+    const auto &labeled_events = this->event_label_manager.labeled_events;
+    Eigen::VectorXf min = featureVectorMap(labeled_events.front());
+    for (std::size_t i = 1; i < labeled_events.size(); ++i) {
+        min = min.cwiseMin(featureVectorMap(labeled_events[i]));
     }
     return min;
 }
 
-template<typename DataPointType> void DataClassifier<DataPointType>::pushToMatrix(const Eigen::VectorXf &vec) {
-    long rows = vec.size();
-    labeled_matrix.resize(rows, labeled_matrix.cols() + 1);
-    labeled_matrix.col(labeled_matrix.cols() - 1) = vec;
-}
-
 template<typename DataPointType> void DataClassifier<DataPointType>::regenerateMatrix() {
+    nearest_neighbour_index.clear();
     if (event_label_manager.labeled_events.empty()) {
         return;
     }
-    this->labeled_matrix = generateMatrixFromLabeledEvents();
-
-    this->generateNormalizationVectors(this->labeled_matrix);
-    this->normalizeMatrix(this->labeled_matrix);
-    nns = std::unique_ptr<Nabo::NNSearchF>(Nabo::NNSearchF::createKDTreeTreeHeap(this->labeled_matrix));
-}
-
-template<typename DataPointType> void DataClassifier<DataPointType>::normalizeMatrix(Eigen::MatrixXf &matrix) {
-    const static Eigen::IOFormat CSVFormat(Eigen::StreamPrecision, Eigen::DontAlignCols, ", ", "\n");
-
-    for (long i = 0; i < matrix.cols(); ++i) {
-        matrix.col(i) = normalizeEvent(matrix.col(i));
+    this->generateNormalizationVectors();
+
+    // the normalized features are written straight into the index, there is no unnormalized copy of the matrix
+    const auto &labeled_events = this->event_label_manager.labeled_events;
+    nearest_neighbour_index.reserve(labeled_events.size(), labeled_events.front().feature_vector.size());
+    for (const auto &labeled_event: labeled_events) {
+        nearest_neighbour_index.insert((featureVectorMap(labeled_event).array() * normalization_mul_vector.array() +
+                                        normalization_add_vector.array()).matrix());
     }
-
+    nearest_neighbour_index.rebuild();
 }
 
 template<typename DataPointType> Eigen::VectorXf DataClassifier<DataPointType>::normalizeEvent(Eigen::VectorXf vec) {
@@ -384,20 +450,25 @@ template<typename DataPointType> Eigen::VectorXf DataClassifier<DataPointType>::
 
 template<typename DataPointType> bool
 DataClassifier<DataPointType>::needToRegenerateMatrixForVector(const Eigen::VectorXf &vec) {
-    return this->classification_config.normalization_mode != NormalizationMode::Rescale ||
-           !featureVectorIsInRange(vec) || this->event_label_manager.labeled_events.size() <= 1;
+    if (this->event_label_manager.labeled_events.size() <= 1 ||
+        nearest_neighbour_index.size() + 1 != this->event_label_manager.labeled_events.size()) {
+        return true;
+    }
+    return this->classification_config.normalization_mode == NormalizationMode::Rescale && !featureVectorIsInRange(vec);
 }
 
 template<typename DataPointType> void
-DataClassifier<DataPointType>::generateFirstNormalizationVectors(const Eigen::MatrixXf &matrix) {
-    normalization_mul_vector = matrix.col(0);
+DataClassifier<DataPointType>::generateFirstNormalizationVectors() {
+    normalization_add_vector = -featureVectorMap(this->event_label_manager.labeled_events.front());
+    normalization_mul_vector = normalization_add_vector;
     normalization_mul_vector.setConstant(1.0);
-    normalization_add_vector = -matrix.col(0);
 }
 
 template<typename DataPointType> void DataClassifier<DataPointType>::addLabel(const LabelTimePair &label) {
-    std::lock_guard<std::mutex> lock(this->events_mutex);
-    this->event_label_manager.addLabel(label);
+    std::lock_guard<std::mutex> lock(this->classifier_mutex);
+    if (this->event_label_manager.addLabel(label)) {
+        this->addEventToNormalizedMatrix(this->event_label_manager.labeled_events.back());
+    }
 
 
 }
@@ -409,45 +480,88 @@ DataClassifier<DataPointType>::addLabels(const std::vector<LabelTimePair> &label
 
 template<typename DataPointType> void
 DataClassifier<DataPointType>::startClassification(const ClassificationConfig &config) {
+    this->join();
 
     this->continue_analyzing = true;
-    feature_extractor.setConfig(config);
-    runner = std::thread(&DataClassifier<DataPointType>::run, this);
+    this->classification_config = config;
+    this->number_of_workers = std::max(config.number_of_classification_threads, 1u);
+    this->feature_extractors.resize(this->number_of_workers);
+    for (auto &feature_extractor: this->feature_extractors) {
+        feature_extractor.setConfig(config);
+    }
+    // events that were dropped by a previous stop never got classified, so the tickets start over
+    this->next_event_ticket = 0;
+    this->events_in_progress = 0;
+    this->next_classification_ticket = 0;
+
+    for (unsigned int i = 0; i < this->number_of_workers; ++i) {
+        this->runners.emplace_back(&DataClassifier<DataPointType>::run, this, i);
+    }
 }
 
-template<typename DataPointType> void DataClassifier<DataPointType>::run() {
+template<typename DataPointType> void DataClassifier<DataPointType>::run(unsigned int worker_id) {
+    FeatureExtractor &feature_extractor = this->feature_extractors[worker_id];
+    std::vector<Event<DataPointType>> taken_events;
 
     while (true) {
-        // wait until an event is pushed
-        std::unique_lock<std::mutex> events_lock(this->events_mutex);
-        this->events_empty_variable.wait(events_lock, [this]() {
-            return !this->events.empty() || !this->continue_analyzing;
-        });
-        // if we dont want to analyze events anymore, quit
-        if (!this->continue_analyzing) {
-            break;
+        unsigned long first_ticket;
+        {
+            // wait until an event is pushed
+            std::unique_lock<std::mutex> events_lock(this->events_mutex);
+            this->events_empty_variable.wait(events_lock, [this]() {
+                return !this->events.empty() || !this->continue_analyzing;
+            });
+            // if we dont want to analyze events anymore, quit
+            if (!this->continue_analyzing) {
+                break;
+            }
+            // a single worker takes all pending events at once. Several workers take one event and one ticket at a time:
+            // a worker waits for its turn to classify only after extracting the features, so the extraction of every
+            // worker overlaps with the classification of the earlier tickets
+            std::size_t number_of_events = this->number_of_workers == 1 ? this->events.size() : 1;
+            taken_events.assign(std::make_move_iterator(this->events.begin()),
+                                std::make_move_iterator(this->events.begin() + number_of_events));
+            this->events.erase(this->events.begin(), this->events.begin() + number_of_events);
+
+            first_ticket = this->next_event_ticket;
+            this->next_event_ticket += number_of_events;
+            this->events_in_progress += number_of_events;
+        }
+
+        // the expensive part runs without holding the events lock, so pushEvent never waits for it
+        for (std::size_t i = 0; i < taken_events.size(); ++i) {
+            if (this->continue_analyzing) {
+                this->processOneEvent(taken_events[i], feature_extractor, first_ticket + i);
+            }
+            {
+                std::lock_guard<std::mutex> events_lock(this->events_mutex);
+                --this->events_in_progress;
+            }
+            this->events_processed_variable.notify_all();
         }
-        this->processOneEvent(this->events.back());
-        this->events.pop_back();
+        taken_events.clear();
     }
+    this->events_processed_variable.notify_all();
 }
 
 template<typename DataPointType> Eigen::MatrixXf DataClassifier<DataPointType>::getNormalizedLabeledMatrix() {
-    return this->labeled_matrix;
+    std::lock_guard<std::mutex> classifier_lock(this->classifier_mutex);
+    return nearest_neighbour_index.points();
 }
 
 template<typename DataPointType> EventLabelManager<DataPointType>
 DataClassifier<DataPointType>::getEventLabelManager() {
 
-    std::lock_guard<std::mutex> events_lock(this->events_mutex);
+    std::lock_guard<std::mutex> classifier_lock(this->classifier_mutex);
     auto x = this->event_label_manager;
     return x;
 }
 
 template<typename DataPointType> void
 DataClassifier<DataPointType>::setEventLabelManager(EventLabelManager<DataPointType> label_manager) {
-    std::lock_guard<std::mutex> l(events_mutex);
+    std::lock_guard<std::mutex> l(classifier_mutex);
     this->event_label_manager = label_manager;
+    recalculateFeatureStatistics();
     regenerateMatrix();
 }
 
@@ -458,21 +572,23 @@ template<typename DataPointType> std::size_t DataClassifier<DataPointType>::getN
 }
 
 template<typename DataPointType> Eigen::MatrixXf DataClassifier<DataPointType>::getUnnormalizedLabeledMatrix() {
-    std::lock_guard<std::mutex> l(events_mutex);
+    std::lock_guard<std::mutex> l(classifier_mutex);
 
     return generateMatrixFromLabeledEvents();
 }
 
 template<typename DataPointType> Eigen::MatrixXf DataClassifier<DataPointType>::generateMatrixFromLabeledEvents() {
     Eigen::MatrixXf result;
+    if (event_label_manager.labeled_events.empty()) {
+        return result;
+    }
 
     long rows = event_label_manager.labeled_events.back().feature_vector.size();
     long cols = event_label_manager.labeled_events.size();
 
     result.resize(rows, cols);
     for (int i = 0; i < cols; ++i) {
-        Eigen::VectorXf vec = convertToEigenVector(this->event_label_manager.labeled_events[i]);
-        result.col(i) = vec;
+        result.col(i) = featureVectorMap(this->event_label_manager.labeled_events[i]);
     }
     return result;
 }
@@ -5,30 +5,44 @@
 #include <cmath>
 #include "EventFeatures.h"
 #include "FastFourierTransformCalculator.h"
+#include "SparseFourierTransformCalculator.h"
 #include "Algorithms.h"
+#include "SampleBlock.h"
 
 class FeatureExtractor {
 public:
     typedef EventFeatures::FeatureType FeatureType;
 
-    template<typename DataPointType> EventFeatures extractFeatures(const Event<DataPointType> &event);
+    /**
+     * @brief Extracts the features of an Event or of an EventView.
+     *
+     * The ampere and voltage values of the event are copied into a SampleBlock once, the RMS values and the spectra are
+     * calculated on its contiguous columns. If the event was detected on a single channel, the features describe the current
+     * of that channel instead of the sum of all channels.
+     */
+    template<typename EventType> EventFeatures extractFeatures(const EventType &event);
 
     void setConfig(ClassificationConfig config);
 
 private:
 
-    template<typename DataPointType> void
-    calcFFTs(const Event<DataPointType> &event);
+    template<typename EventType> void
+    calcFFTs(const EventType &event);
 
-    template<typename DataPointType> void
-    extractRms(const Event<DataPointType> &event, std::vector<FeatureType> &feature_vec);
+    template<typename EventType> void
+    calcSparseSpectra(const EventType &event, unsigned long num_data_points);
 
+    unsigned long spectrumBaseFrequencyPos(const PowerMetaData &meta_data);
 
-    template<typename DataPointType> void
-    extractHarmonics(const Event<DataPointType> &event, std::vector<FeatureExtractor::FeatureType> &feature_vec);
+    template<typename EventType> void
+    extractRms(const EventType &event, std::vector<FeatureType> &feature_vec);
 
-    template<typename DataPointType> void
-    extractPhaseShift(const Event<DataPointType> &event, std::vector<FeatureExtractor::FeatureType> &feature_vec);
+
+    template<typename EventType> void
+    extractHarmonics(const EventType &event, std::vector<FeatureExtractor::FeatureType> &feature_vec);
+
+    template<typename EventType> void
+    extractPhaseShift(const EventType &event, std::vector<FeatureExtractor::FeatureType> &feature_vec);
 
     float calcPhaseShift(const std::vector<kiss_fft_cpx> &amps, const std::vector<kiss_fft_cpx> &volts,
                          unsigned long base_freq_pos);
@@ -38,7 +52,18 @@ private:
 
 private:
     ClassificationConfig classification_config;
+    SampleBlock samples;
+    // position of event_begin in the samples
+    unsigned long event_offset = 0;
+    std::vector<float> period_rms;
     FastFourierTransformCalculator fft_calculator;
+    SparseFourierTransformCalculator sparse_calculator;
+    // the spectra only hold the non redundant half of the points of the real input FFTs
+    unsigned long fft_input_length = 0;
+    // with SpectrumMode::SparseFourierTransform the ampere spectra hold the base frequency followed by the
+    // harmonics_search_radius * 2 bins around each harmonic and the voltage spectra only hold the base frequency
+    std::vector<unsigned long> sparse_ampere_bins;
+    std::vector<unsigned long> sparse_voltage_bins;
     std::vector<kiss_fft_cpx> fft_ampere_before;
     std::vector<kiss_fft_cpx> fft_ampere_after;
     std::vector<kiss_fft_cpx> fft_voltage_before;
@@ -47,41 +72,46 @@ private:
 
 };
 
-template<typename DataPointType> EventFeatures FeatureExtractor::extractFeatures(const Event<DataPointType> &event) {
+template<typename EventType> EventFeatures FeatureExtractor::extractFeatures(const EventType &event) {
+    if (event.event_meta_data.channel) {
+        this->samples.assign(event.before_event_begin(), event.event_end(), *event.event_meta_data.channel);
+    } else {
+        this->samples.assign(event.before_event_begin(), event.event_end());
+    }
+    this->event_offset = static_cast<unsigned long>(event.event_begin() - event.before_event_begin());
     calcFFTs(event);
     std::vector<FeatureType> f_vect;
-    extractPhaseShift<DataPointType>(event, f_vect);
+    extractPhaseShift(event, f_vect);
 
-    extractRms<DataPointType>(event, f_vect);
-    extractHarmonics<DataPointType>(event, f_vect);
+    extractRms(event, f_vect);
+    extractHarmonics(event, f_vect);
     return EventFeatures(event.event_meta_data, f_vect);
 }
 
 
-template<typename DataPointType> void FeatureExtractor::extractRms(const Event<DataPointType> &event,
+template<typename EventType> void FeatureExtractor::extractRms(const EventType &event,
                                                                    std::vector<FeatureExtractor::FeatureType> &feature_vec) {
     FeatureType sub_rms = 0;
     unsigned long data_points_per_period = event.event_meta_data.power_meta_data.dataPointsPerPeriod();
     if (event.event_meta_data.power_meta_data.data_points_stored_before_event >= data_points_per_period) {
-        sub_rms = Algorithms::rootMeanSquareOfAmpere(event.before_event_begin(),
-                                                     event.before_event_begin() + data_points_per_period);
+        sub_rms = Algorithms::rootMeanSquare(this->samples.ampereBegin(),
+                                             this->samples.ampereBegin() + data_points_per_period);
     }
 
     long loop_end = event.event_end() - event.event_begin() - data_points_per_period;
-    auto begin = event.event_begin();
-    auto end = event.event_begin() + data_points_per_period;
-    int period_count = 0;
-    for (long count = 0; count < loop_end; count += data_points_per_period) {
-        FeatureType rms = Algorithms::rootMeanSquareOfAmpere(begin, end);
-        rms -= sub_rms;
-        feature_vec.push_back(rms);
-
-        begin += data_points_per_period;
-        end += data_points_per_period;
-
-        if (period_count >= classification_config.number_of_rms) break;
-        ++period_count;
-
+    if (loop_end <= 0 || data_points_per_period == 0) {
+        return;
+    }
+    // every period that starts before loop_end, but at most number_of_rms + 1 of them
+    unsigned long number_of_periods = (loop_end + data_points_per_period - 1) / data_points_per_period;
+    number_of_periods = std::min(number_of_periods,
+                                 static_cast<unsigned long>(std::max(classification_config.number_of_rms, 0)) + 1);
+
+    this->period_rms.resize(number_of_periods);
+    Algorithms::rootMeanSquareOfPeriods(this->samples.ampereBegin() + this->event_offset, data_points_per_period,
+                                        number_of_periods, this->period_rms.data());
+    for (FeatureType rms: this->period_rms) {
+        feature_vec.push_back(rms - sub_rms);
     }
 }
 
@@ -90,38 +120,85 @@ void FeatureExtractor::setConfig(ClassificationConfig config) {
 
 }
 
-template<typename DataPointType> void
-FeatureExtractor::calcFFTs(const Event<DataPointType> &event) {
+template<typename EventType> void
+FeatureExtractor::calcFFTs(const EventType &event) {
     unsigned long num_data_points = event.before_event_end() - event.before_event_begin();
     num_data_points = std::min(num_data_points, static_cast<unsigned long>(event.event_end() - event.event_begin()));
 
-    fft_ampere_before = fft_calculator.calculateAmpereFFTWithBlackmanHarris(event.before_event_begin(),
-                                                                            event.before_event_begin() +
-                                                                            num_data_points);
-    fft_voltage_before = fft_calculator.calculateVoltageFFTWithBlackmanHarris(event.before_event_begin(),
-                                                                              event.before_event_begin() +
-                                                                              num_data_points);
-
-    fft_ampere_after = fft_calculator.calculateAmpereFFTWithBlackmanHarris(event.event_begin(),
-                                                                           event.event_begin() + num_data_points);
-    fft_voltage_after = fft_calculator.calculateVoltageFFTWithBlackmanHarris(event.event_begin(),
-                                                                             event.event_begin() + num_data_points);
+    this->fft_input_length = num_data_points;
+
+    if (classification_config.spectrum_mode == SpectrumMode::SparseFourierTransform) {
+        calcSparseSpectra(event, num_data_points);
+        return;
+    }
+
+    const float *ampere = this->samples.ampereBegin();
+    const float *voltage = this->samples.voltageBegin();
+    fft_calculator.calculateRealFFTWithBlackmanHarris(ampere, ampere + num_data_points, fft_ampere_before);
+    fft_calculator.calculateRealFFTWithBlackmanHarris(voltage, voltage + num_data_points, fft_voltage_before);
+
+    ampere += this->event_offset;
+    voltage += this->event_offset;
+    fft_calculator.calculateRealFFTWithBlackmanHarris(ampere, ampere + num_data_points, fft_ampere_after);
+    fft_calculator.calculateRealFFTWithBlackmanHarris(voltage, voltage + num_data_points, fft_voltage_after);
 }
 
+template<typename EventType> void
+FeatureExtractor::calcSparseSpectra(const EventType &event, unsigned long num_data_points) {
+    unsigned long base_frequency_pos = calcBaseFrequencyPos(event.event_meta_data.power_meta_data, num_data_points);
+    unsigned long search_radius = classification_config.harmonics_search_radius;
+    assert(base_frequency_pos * 2 >= search_radius);
+
+    sparse_voltage_bins.assign(1, base_frequency_pos);
+    sparse_ampere_bins.assign(1, base_frequency_pos);
+    for (unsigned long i = 2; i <= classification_config.number_of_harmonics + 1; ++i) {
+        if (search_radius == 0) {
+            sparse_ampere_bins.push_back(i * base_frequency_pos);
+        }
+        for (unsigned long bin = i * base_frequency_pos - search_radius;
+             bin < i * base_frequency_pos + search_radius; ++bin) {
+            sparse_ampere_bins.push_back(bin);
+        }
+    }
+
+    const float *ampere = this->samples.ampereBegin();
+    const float *voltage = this->samples.voltageBegin();
+    sparse_calculator.calculateBinsWithBlackmanHarris(ampere, ampere + num_data_points, sparse_ampere_bins,
+                                                      fft_ampere_before);
+    sparse_calculator.calculateBinsWithBlackmanHarris(voltage, voltage + num_data_points, sparse_voltage_bins,
+                                                      fft_voltage_before);
+
+    ampere += this->event_offset;
+    voltage += this->event_offset;
+    sparse_calculator.calculateBinsWithBlackmanHarris(ampere, ampere + num_data_points, sparse_ampere_bins,
+                                                      fft_ampere_after);
+    sparse_calculator.calculateBinsWithBlackmanHarris(voltage, voltage + num_data_points, sparse_voltage_bins,
+                                                      fft_voltage_after);
+}
 
-template<typename DataPointType> void FeatureExtractor::extractHarmonics(const Event<DataPointType> &event,
-                                                                         std::vector<FeatureExtractor::FeatureType> &feature_vec) {
 
-    unsigned long base_frequency_pos = calcBaseFrequencyPos(event.event_meta_data.power_meta_data, fft_ampere_before.size());
-    std::vector<FeatureExtractor::FeatureType> harm_old = Algorithms::getHarmonics(fft_ampere_before,
-                                                                                   base_frequency_pos,
-                                                                                   classification_config.number_of_harmonics,
-                                                                                   classification_config.harmonics_search_radius);
+template<typename EventType> void FeatureExtractor::extractHarmonics(const EventType &event,
+                                                                         std::vector<FeatureExtractor::FeatureType> &feature_vec) {
 
-    std::vector<FeatureExtractor::FeatureType> harm_new = Algorithms::getHarmonics(fft_ampere_after,
-                                                                                   base_frequency_pos,
-                                                                                   classification_config.number_of_harmonics,
-                                                                                   classification_config.harmonics_search_radius);
+    std::vector<FeatureExtractor::FeatureType> harm_old;
+    std::vector<FeatureExtractor::FeatureType> harm_new;
+    if (classification_config.spectrum_mode == SpectrumMode::SparseFourierTransform) {
+        harm_old = Algorithms::getHarmonicsOfNeighbourhoods(fft_ampere_before.begin() + 1,
+                                                            classification_config.number_of_harmonics,
+                                                            classification_config.harmonics_search_radius);
+        harm_new = Algorithms::getHarmonicsOfNeighbourhoods(fft_ampere_after.begin() + 1,
+                                                            classification_config.number_of_harmonics,
+                                                            classification_config.harmonics_search_radius);
+    } else {
+        unsigned long base_frequency_pos = calcBaseFrequencyPos(event.event_meta_data.power_meta_data,
+                                                                this->fft_input_length);
+        harm_old = Algorithms::getHarmonics(fft_ampere_before, base_frequency_pos,
+                                            classification_config.number_of_harmonics,
+                                            classification_config.harmonics_search_radius);
+        harm_new = Algorithms::getHarmonics(fft_ampere_after, base_frequency_pos,
+                                            classification_config.number_of_harmonics,
+                                            classification_config.harmonics_search_radius);
+    }
     auto old_iter = harm_old.begin();
     for (auto &harmonic: harm_new) {
         feature_vec.push_back(std::abs(harmonic) - std::abs(*old_iter));
@@ -129,10 +206,10 @@ template<typename DataPointType> void FeatureExtractor::extractHarmonics(const E
     }
 }
 
-template<typename DataPointType> void FeatureExtractor::extractPhaseShift(const Event<DataPointType> &event,
+template<typename EventType> void FeatureExtractor::extractPhaseShift(const EventType &event,
                                                                           std::vector<FeatureExtractor::FeatureType> &feature_vec) {
 
-    unsigned long base_frequency_pos = calcBaseFrequencyPos(event.event_meta_data.power_meta_data, fft_ampere_before.size());
+    unsigned long base_frequency_pos = spectrumBaseFrequencyPos(event.event_meta_data.power_meta_data);
 
     float phase_shift_before = calcPhaseShift(fft_ampere_before, fft_voltage_before, base_frequency_pos);
 
@@ -162,6 +239,13 @@ float FeatureExtractor::calcPhaseShift(const std::vector<kiss_fft_cpx> &amps, co
     return phase_tmp;
 }
 
+unsigned long FeatureExtractor::spectrumBaseFrequencyPos(const PowerMetaData &meta_data) {
+    if (classification_config.spectrum_mode == SpectrumMode::SparseFourierTransform) {
+        return 0;
+    }
+    return calcBaseFrequencyPos(meta_data, this->fft_input_length);
+}
+
 unsigned long
 FeatureExtractor::calcBaseFrequencyPos(const PowerMetaData &meta_data, unsigned long number_of_data_points_in_fft) {
     float result = number_of_data_points_in_fft;
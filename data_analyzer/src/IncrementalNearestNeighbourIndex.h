@@ -0,0 +1,199 @@
+#ifndef SMART_SCREEN_INCREMENTALNEARESTNEIGHBOURINDEX_H
+#define SMART_SCREEN_INCREMENTALNEARESTNEIGHBOURINDEX_H
+
+#include <vector>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <iostream>
+#include <exception>
+#include <Eigen/StdVector>
+#include <nabo/nabo.h>
+
+/**
+ * @brief A nearest neighbour index that supports cheap inserts.
+ *
+ * The points are stored column after column in one aligned buffer whose capacity grows geometrically, so appending a point is
+ * amortized O(dimensions). rebuild copies all points into a matrix and indexes it with a libnabo kd-tree, libnabo only
+ * instantiates its searches for plain matrices. Points inserted afterwards form an unindexed tail that is searched brute force,
+ * and knn merges the results of both.
+ * The index of a point is its insertion position. needsRebuild tells when the tail got too large compared to the kd-tree, so
+ * rebuilds happen after a constant fraction of new points and their cost is amortized over the inserts.
+ */
+class IncrementalNearestNeighbourIndex {
+public:
+    typedef Eigen::MatrixXf MatrixType;
+    typedef Eigen::VectorXf VectorType;
+    typedef Eigen::VectorXi IndexVectorType;
+    typedef Nabo::NNSearchF SearchType;
+
+    /**
+     * @brief Builds the kd-tree over all points, which empties the tail.
+     */
+    void rebuild();
+
+    template<typename VectorExpressionType> void insert(const Eigen::MatrixBase<VectorExpressionType> &point);
+
+    /**
+     * @brief Removes all points. The capacity is kept.
+     */
+    void clear();
+
+    /**
+     * @brief Reserves memory for points_to_reserve points of the given number of dimensions.
+     */
+    void reserve(unsigned long points_to_reserve, long dimensions_to_reserve);
+
+    /**
+     * @brief Finds the k nearest neighbours of query. Returns the number of neighbours found, which is less than k if the index
+     * has less than k points. Like libnabo's default, points at exactly the position of the query are not returned.
+     */
+    unsigned long knn(const VectorType &query, IndexVectorType &indices, VectorType &dists2, unsigned long k) const;
+
+    bool needsRebuild() const {
+        return this->unindexedSize() * unindexed_points_divisor > this->indexed_points;
+    }
+
+    unsigned long size() const {
+        return this->number_of_points;
+    }
+
+    unsigned long indexedSize() const {
+        return this->indexed_points;
+    }
+
+    unsigned long unindexedSize() const {
+        return this->number_of_points - this->indexed_points;
+    }
+
+    long dimensions() const {
+        return this->number_of_dimensions;
+    }
+
+    /**
+     * @brief All points, one per column.
+     */
+    Eigen::Map<const MatrixType> points() const {
+        return Eigen::Map<const MatrixType>(this->buffer.data(), this->number_of_dimensions, this->number_of_points);
+    }
+
+    /**
+     * @brief The points that were inserted since the last rebuild, one per column.
+     */
+    Eigen::Map<const MatrixType> unindexedPoints() const {
+        return Eigen::Map<const MatrixType>(this->buffer.data() + this->indexed_points * this->number_of_dimensions,
+                                            this->number_of_dimensions, this->unindexedSize());
+    }
+
+private:
+    void buildSearch();
+
+private:
+    enum {
+        // the tail may grow to 1 / unindexed_points_divisor of the indexed points before a rebuild is due
+        unindexed_points_divisor = 8,
+        initial_capacity = 64
+    };
+
+    std::vector<float, Eigen::aligned_allocator<float>> buffer;
+    unsigned long number_of_points = 0;
+    long number_of_dimensions = 0;
+
+    unsigned long indexed_points = 0;
+    // libnabo keeps a reference to the cloud, so it has to live as long as the search and must not move
+    std::unique_ptr<MatrixType> cloud;
+    std::unique_ptr<SearchType> nns;
+};
+
+inline void IncrementalNearestNeighbourIndex::rebuild() {
+    this->indexed_points = this->number_of_points;
+    this->buildSearch();
+}
+
+inline void IncrementalNearestNeighbourIndex::buildSearch() {
+    this->nns.reset();
+    this->cloud.reset();
+    if (this->indexed_points == 0) {
+        return;
+    }
+    this->cloud.reset(new MatrixType(this->points().leftCols(this->indexed_points)));
+    this->nns.reset(SearchType::createKDTreeTreeHeap(*this->cloud));
+}
+
+template<typename VectorExpressionType> void
+IncrementalNearestNeighbourIndex::insert(const Eigen::MatrixBase<VectorExpressionType> &point) {
+    if (this->number_of_points == 0) {
+        this->number_of_dimensions = point.size();
+    }
+    if (point.size() != this->number_of_dimensions) {
+        std::cerr << "Point with " << point.size() << " dimensions does not fit into an index of "
+                  << this->number_of_dimensions << " dimensions\n";
+        throw std::exception();
+    }
+
+    const unsigned long needed_size = (this->number_of_points + 1) * this->number_of_dimensions;
+    if (needed_size > this->buffer.capacity()) {
+        this->buffer.reserve(std::max<unsigned long>(needed_size, std::max<unsigned long>(
+                this->buffer.capacity() * 2, initial_capacity * this->number_of_dimensions)));
+    }
+    this->buffer.resize(needed_size);
+    Eigen::Map<VectorType>(this->buffer.data() + this->number_of_points * this->number_of_dimensions,
+                           this->number_of_dimensions) = point;
+    ++this->number_of_points;
+}
+
+inline void IncrementalNearestNeighbourIndex::clear() {
+    this->nns.reset();
+    this->cloud.reset();
+    this->buffer.clear();
+    this->number_of_points = 0;
+    this->indexed_points = 0;
+}
+
+inline void IncrementalNearestNeighbourIndex::reserve(unsigned long points_to_reserve, long dimensions_to_reserve) {
+    if (this->number_of_points == 0) {
+        this->number_of_dimensions = dimensions_to_reserve;
+    }
+    this->buffer.reserve(points_to_reserve * dimensions_to_reserve);
+}
+
+inline unsigned long
+IncrementalNearestNeighbourIndex::knn(const VectorType &query, IndexVectorType &indices, VectorType &dists2,
+                                      unsigned long k) const {
+    k = std::min(k, this->size());
+    std::vector<std::pair<float, int>> candidates;
+    candidates.reserve(k + this->unindexedSize());
+
+    const unsigned long indexed_k = std::min(k, this->indexedSize());
+    if (indexed_k > 0) {
+        IndexVectorType indexed_indices(indexed_k);
+        VectorType indexed_dists2(indexed_k);
+        this->nns->knn(query, indexed_indices, indexed_dists2, static_cast<int>(indexed_k));
+        for (unsigned long i = 0; i < indexed_k; ++i) {
+            if (indexed_dists2(i) != std::numeric_limits<float>::infinity()) {
+                candidates.emplace_back(indexed_dists2(i), indexed_indices(i));
+            }
+        }
+    }
+
+    auto unindexed = this->unindexedPoints();
+    for (unsigned long i = 0; i < this->unindexedSize(); ++i) {
+        float dist2 = (unindexed.col(i) - query).squaredNorm();
+        if (dist2 > 0) {
+            candidates.emplace_back(dist2, static_cast<int>(this->indexedSize() + i));
+        }
+    }
+
+    k = std::min<unsigned long>(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end());
+    indices.resize(k);
+    dists2.resize(k);
+    for (unsigned long i = 0; i < k; ++i) {
+        dists2(i) = candidates[i].first;
+        indices(i) = candidates[i].second;
+    }
+    return k;
+}
+
+#endif //SMART_SCREEN_INCREMENTALNEARESTNEIGHBOURINDEX_H
@@ -1,7 +1,8 @@
 #ifndef _DATAMANAGER_H_
 #define _DATAMANAGER_H_
 
-#include <deque>
+#include <memory>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <iostream>
@@ -11,17 +12,33 @@
 
 #include "DefaultDataPoint.h"
 #include "PowerMetaData.h"
+#include "DataPointWindow.h"
+
+/**
+ * @brief Queue policy: a contiguous buffer guarded by a mutex and two condition variables. Any number of threads may read and write.
+ */
+struct LockedQueuePolicy {
+};
+
+/**
+ * @brief Queue policy: a fixed capacity lock free ring buffer. Exactly one thread may write and exactly one thread may read.
+ */
+struct SpscRingQueuePolicy {
+};
 
 /**
  * @brief The DataManager is a synchronized point for asynchronous reading and writing operations.
  *
+ * The QueuePolicy selects the storage and synchronization backend. Every backend offers the same interface and the same stream end and discard semantics.
  */
-template<typename DataPointType> class AsyncDataQueue;
+template<typename DataPointType, typename QueuePolicy = LockedQueuePolicy> class AsyncDataQueue;
 
 typedef AsyncDataQueue<DefaultDataPoint> DefaultDataManager;
 
-template<typename DataPointType> class AsyncDataQueue {
+template<typename DataPointType> class AsyncDataQueue<DataPointType, LockedQueuePolicy> {
 public:
+    AsyncDataQueue();
+
     ~AsyncDataQueue();
 
     void setQueueMaxSize(unsigned long max_size);
@@ -31,6 +48,7 @@ public:
     unsigned long getQueueSize();
 
     void restartStreaming() {
+        std::unique_lock<std::mutex> lock(data_queue_mutex);
         this->stream_ended = false;
     }
 
@@ -45,6 +63,26 @@ public:
     template<class IteratorType> IteratorType
     getDataPoints(IteratorType begin, IteratorType end, unsigned long offset = 0);
 
+    /**
+     * @brief Blocks until num_data_points data points after offset are in the queue and returns a read only window on them without copying. If the stream ended, the window may be shorter.
+     *
+     * The window stays valid until the data points are removed with nextDataPoints or popDataPoints. Only one thread may read from the queue while a window is held.
+     *
+     * @param num_data_points Number of data points in the window.
+     * @param offset Number of data points at the front of the queue that are skipped.
+     *
+     */
+    DataPointWindow<DataPointType> peekDataPoints(unsigned long num_data_points, unsigned long offset = 0);
+
+    /**
+     * @brief Returns true if reading num_data_points data points would not block, because they are in the queue or the stream
+     * has ended.
+     */
+    bool canRead(unsigned long num_data_points) {
+        std::unique_lock<std::mutex> queue_lock(this->data_queue_mutex);
+        return this->getQueueHasEnoughElementsWaiter(num_data_points)();
+    }
+
 
     /**
      * @brief Removes num_data_points DataPoints from the queue
@@ -96,9 +134,11 @@ public:
 
     void discardRestOfStream() {
         std::unique_lock<std::mutex> lock(data_queue_mutex);
-        this->data_queue.clear();
+        this->read_position = 0;
+        this->write_position = 0;
         this->stream_ended = true;
-        this->deque_overflow.notify_all();
+        this->queue_overflow.notify_all();
+        this->queue_underflow.notify_all();
     }
 
 
@@ -111,142 +151,196 @@ private:
 
     void removePointsFromQueue(unsigned long num_data_points);
 
+    void resizeBuffer(unsigned long max_size);
+
+    unsigned long queueSize() const {
+        return this->write_position - this->read_position;
+    }
+
 
 private:
-    std::condition_variable deque_overflow;
-    std::condition_variable deque_underflow;
+    std::condition_variable queue_overflow;
+    std::condition_variable queue_underflow;
     std::mutex data_queue_mutex;
-    std::deque<DataPointType> data_queue;
-    bool stream_ended = false;
+    // the data points in the queue are buffer[read_position, write_position). The reader moves them back to the front
+    // before less than queue_max_size elements fit behind them, so the writer never runs out of space and windows stay contiguous.
+    std::unique_ptr<DataPointType[]> buffer;
+    unsigned long buffer_capacity = 0;
+    unsigned long read_position = 0;
+    unsigned long write_position = 0;
+    std::atomic<bool> stream_ended{false};
 
     unsigned long queue_max_size = 4096;
 };
 
 
-template<typename DataPointType> AsyncDataQueue<DataPointType>::~AsyncDataQueue() {
+template<typename DataPointType> AsyncDataQueue<DataPointType, LockedQueuePolicy>::AsyncDataQueue() {
+    this->resizeBuffer(this->queue_max_size);
+}
+
+template<typename DataPointType> AsyncDataQueue<DataPointType, LockedQueuePolicy>::~AsyncDataQueue() {
     {
         std::lock_guard<std::mutex> clear_queue(data_queue_mutex);
-        data_queue.clear();
+        this->read_position = 0;
+        this->write_position = 0;
     }
-    deque_overflow.notify_all();
+    queue_overflow.notify_all();
 }
 
-template<typename DataPointType> unsigned long AsyncDataQueue<DataPointType>::getQueueMaxSize() {
+template<typename DataPointType> unsigned long AsyncDataQueue<DataPointType, LockedQueuePolicy>::getQueueMaxSize() {
     return this->queue_max_size;
 }
 
-template<typename DataPointType> unsigned long AsyncDataQueue<DataPointType>::getQueueSize() {
+template<typename DataPointType> unsigned long AsyncDataQueue<DataPointType, LockedQueuePolicy>::getQueueSize() {
     std::unique_lock<std::mutex> queue_lock(this->data_queue_mutex);
 
-    return this->data_queue.size();
+    return this->queueSize();
 }
 
-template<typename DataPointType> void AsyncDataQueue<DataPointType>::setQueueMaxSize(unsigned long max_size) {
+template<typename DataPointType> void AsyncDataQueue<DataPointType, LockedQueuePolicy>::setQueueMaxSize(unsigned long max_size) {
     std::unique_lock<std::mutex> queue_lock(this->data_queue_mutex);
     this->queue_max_size = max_size;
-    this->deque_overflow.notify_one();
+    this->resizeBuffer(max_size);
+    this->queue_overflow.notify_one();
+}
+
+template<typename DataPointType> void AsyncDataQueue<DataPointType, LockedQueuePolicy>::resizeBuffer(unsigned long max_size) {
+    unsigned long new_capacity = 2 * std::max(max_size, this->queueSize());
+    std::unique_ptr<DataPointType[]> new_buffer(new DataPointType[new_capacity]);
+    std::copy(this->buffer.get() + this->read_position, this->buffer.get() + this->write_position, new_buffer.get());
+    this->write_position = this->queueSize();
+    this->read_position = 0;
+    this->buffer = std::move(new_buffer);
+    this->buffer_capacity = new_capacity;
 }
 
 
 template<typename DataPointType> template<typename IteratorType> void
-AsyncDataQueue<DataPointType>::addDataPoints(IteratorType begin, IteratorType end) {
+AsyncDataQueue<DataPointType, LockedQueuePolicy>::addDataPoints(IteratorType begin, IteratorType end) {
     auto waiting_function = this->getQueueNotFullWaiter();
 
     while (begin != end && !this->stream_ended) {
-        std::unique_lock<std::mutex> deque_overflow_wait_lock(this->data_queue_mutex);
-        this->deque_overflow.wait(deque_overflow_wait_lock, waiting_function);
-        unsigned long pushable_elements = this->queue_max_size - this->data_queue.size();
+        std::unique_lock<std::mutex> queue_wait_lock(this->data_queue_mutex);
+        this->queue_overflow.wait(queue_wait_lock, waiting_function);
+        unsigned long pushable_elements = this->queue_max_size - this->queueSize();
         unsigned long elements_pushed = std::min(static_cast<unsigned long>(end - begin), pushable_elements);
-        this->data_queue.insert(data_queue.end(), begin, begin + elements_pushed);
+        std::copy_n(begin, elements_pushed, this->buffer.get() + this->write_position);
+        this->write_position += elements_pushed;
         begin += elements_pushed;
-        this->deque_underflow.notify_one();
+        this->queue_underflow.notify_one();
     }
 }
 
 
 template<typename DataPointType> template<typename IteratorType> IteratorType
-AsyncDataQueue<DataPointType>::getDataPoints(IteratorType begin, IteratorType end, unsigned long offset) {
+AsyncDataQueue<DataPointType, LockedQueuePolicy>::getDataPoints(IteratorType begin, IteratorType end, unsigned long offset) {
     auto waiting_function = this->getQueueHasEnoughElementsWaiter(static_cast<long>(end - begin) + offset);
-    std::unique_lock<std::mutex> deque_overflow_wait_lock(this->data_queue_mutex);
-    this->deque_underflow.wait(deque_overflow_wait_lock, waiting_function);
-    long pullable_elements = this->data_queue.size() - offset;
+    std::unique_lock<std::mutex> queue_wait_lock(this->data_queue_mutex);
+    this->queue_underflow.wait(queue_wait_lock, waiting_function);
+    long pullable_elements = static_cast<long>(this->queueSize()) - static_cast<long>(offset);
     long elements_pulled = std::min(static_cast<long>(end - begin), pullable_elements);
-    begin = std::copy_n(data_queue.begin() + offset, elements_pulled, begin);
+    if (elements_pulled <= 0) {
+        return begin;
+    }
+    begin = std::copy_n(this->buffer.get() + this->read_position + offset, elements_pulled, begin);
     return begin;
 }
 
-template<typename DataPointType> void AsyncDataQueue<DataPointType>::nextDataPoints(unsigned long num_data_points) {
-    std::unique_lock<std::mutex> deque_overflow_wait_lock(this->data_queue_mutex);
+template<typename DataPointType> DataPointWindow<DataPointType>
+AsyncDataQueue<DataPointType, LockedQueuePolicy>::peekDataPoints(unsigned long num_data_points, unsigned long offset) {
+    auto waiting_function = this->getQueueHasEnoughElementsWaiter(num_data_points + offset);
+    std::unique_lock<std::mutex> queue_underflow_wait_lock(this->data_queue_mutex);
+    this->queue_underflow.wait(queue_underflow_wait_lock, waiting_function);
+    if (this->queueSize() <= offset) {
+        return DataPointWindow<DataPointType>();
+    }
+    unsigned long window_size = std::min(num_data_points, this->queueSize() - offset);
+    const DataPointType *window_begin = this->buffer.get() + this->read_position + offset;
+    return DataPointWindow<DataPointType>(window_begin, window_begin + window_size);
+}
+
+template<typename DataPointType> void AsyncDataQueue<DataPointType, LockedQueuePolicy>::nextDataPoints(unsigned long num_data_points) {
+    std::unique_lock<std::mutex> queue_wait_lock(this->data_queue_mutex);
 
     auto queue_has_enough_elements = this->getQueueHasEnoughElementsWaiter(num_data_points);
-    this->deque_underflow.wait(deque_overflow_wait_lock, queue_has_enough_elements);
+    this->queue_underflow.wait(queue_wait_lock, queue_has_enough_elements);
     this->removePointsFromQueue(num_data_points);
-    this->deque_overflow.notify_one();
+    this->queue_overflow.notify_one();
 }
 
 
-template<typename DataPointType> void AsyncDataQueue<DataPointType>::addDataPoint(DataPointType data_point) {
-    std::unique_lock<std::mutex> deque_overflow_wait_lock(this->data_queue_mutex);
+template<typename DataPointType> void AsyncDataQueue<DataPointType, LockedQueuePolicy>::addDataPoint(DataPointType data_point) {
+    std::unique_lock<std::mutex> queue_wait_lock(this->data_queue_mutex);
 
     auto queue_not_full = this->getQueueNotFullWaiter();
-    this->deque_overflow.wait(deque_overflow_wait_lock, queue_not_full);
+    this->queue_overflow.wait(queue_wait_lock, queue_not_full);
 
-    this->data_queue.push_back(data_point);
-    this->deque_underflow.notify_one();
+    this->buffer[this->write_position] = data_point;
+    ++this->write_position;
+    this->queue_underflow.notify_one();
 
 }
 
 template<typename DataPointType> std::function<bool()>
-AsyncDataQueue<DataPointType>::getQueueHasEnoughElementsWaiter(unsigned long num_elements) {
+AsyncDataQueue<DataPointType, LockedQueuePolicy>::getQueueHasEnoughElementsWaiter(unsigned long num_elements) {
     return [this, num_elements]() -> bool {
-        return this->data_queue.size() >= num_elements || this->stream_ended;
+        return this->queueSize() >= num_elements || this->stream_ended;
     };
 }
 
-template<typename DataPointType> std::function<bool()> AsyncDataQueue<DataPointType>::getQueueNotEmptyWaiter() {
+template<typename DataPointType> std::function<bool()> AsyncDataQueue<DataPointType, LockedQueuePolicy>::getQueueNotEmptyWaiter() {
     return [this]() -> bool {
-        return this->data_queue.size() > 0 || this->stream_ended;
+        return this->queueSize() > 0 || this->stream_ended;
     };
 }
 
-template<typename DataPointType> std::function<bool()> AsyncDataQueue<DataPointType>::getQueueNotFullWaiter() {
+template<typename DataPointType> std::function<bool()> AsyncDataQueue<DataPointType, LockedQueuePolicy>::getQueueNotFullWaiter() {
     return [this]() -> bool {
-        return this->data_queue.size() < this->queue_max_size || this->stream_ended;
+        return this->queueSize() < this->queue_max_size || this->stream_ended;
     };
 }
 
-template<typename DataPointType> void AsyncDataQueue<DataPointType>::notifyStreamEnd() {
-    this->stream_ended = true;
-    this->deque_underflow.notify_one();
+template<typename DataPointType> void AsyncDataQueue<DataPointType, LockedQueuePolicy>::notifyStreamEnd() {
+    {
+        std::lock_guard<std::mutex> lock(data_queue_mutex);
+        this->stream_ended = true;
+    }
+    this->queue_underflow.notify_all();
 }
 
 template<typename DataPointType> template<class IteratorType> IteratorType
-AsyncDataQueue<DataPointType>::popDataPoints(IteratorType begin, IteratorType end) {
+AsyncDataQueue<DataPointType, LockedQueuePolicy>::popDataPoints(IteratorType begin, IteratorType end) {
     auto waiting_function = this->getQueueNotEmptyWaiter();
     do {
-        std::unique_lock<std::mutex> deque_overflow_wait_lock(this->data_queue_mutex);
+        std::unique_lock<std::mutex> queue_wait_lock(this->data_queue_mutex);
 
-        this->deque_underflow.wait(deque_overflow_wait_lock, waiting_function);
+        this->queue_underflow.wait(queue_wait_lock, waiting_function);
 
-        long pullable_elements = this->data_queue.size();
+        long pullable_elements = this->queueSize();
         long elements_pulled = std::min(static_cast<long>(end - begin), pullable_elements);
-        begin = std::copy_n(data_queue.begin(), elements_pulled, begin);
+        begin = std::copy_n(this->buffer.get() + this->read_position, elements_pulled, begin);
         this->removePointsFromQueue(elements_pulled);
-        this->deque_overflow.notify_one();
+        this->queue_overflow.notify_one();
 
     } while (begin != end && !this->stream_ended);
     return begin;
 }
 
-template<typename DataPointType> void AsyncDataQueue<DataPointType>::removePointsFromQueue(unsigned long num_data_points) {
-    if (num_data_points >= this->data_queue.size()) {
-        data_queue.clear();
+template<typename DataPointType> void AsyncDataQueue<DataPointType, LockedQueuePolicy>::removePointsFromQueue(unsigned long num_data_points) {
+    if (num_data_points >= this->queueSize()) {
+        this->read_position = 0;
+        this->write_position = 0;
         return;
     }
-    this->data_queue.erase(data_queue.begin(), data_queue.begin() + num_data_points);
-
-
+    this->read_position += num_data_points;
+    if (this->read_position >= this->buffer_capacity - this->queue_max_size) {
+        std::copy(this->buffer.get() + this->read_position, this->buffer.get() + this->write_position,
+                  this->buffer.get());
+        this->write_position -= this->read_position;
+        this->read_position = 0;
+    }
 }
 
+#include "SpscRingDataQueue.h"
 
 #endif // _DATAMANAGER_H_
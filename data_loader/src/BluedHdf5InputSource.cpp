@@ -1,60 +1,174 @@
 #include "BluedHdf5InputSource.h"
+#include "BluedHdf5TimeIndex.h"
 
 #include <exception>
+#include <cstddef>
+#include <iostream>
+#include <algorithm>
+#include <limits>
+
+// the rows of the data set are read straight into BluedDataPoints, so both have to have the same layout
+static_assert(sizeof(BluedDataPoint) == 4 * sizeof(float), "BluedDataPoint must be four packed floats");
+static_assert(offsetof(BluedDataPoint, x_value) == 0 && offsetof(BluedDataPoint, current_a) == sizeof(float) &&
+              offsetof(BluedDataPoint, current_b) == 2 * sizeof(float) &&
+              offsetof(BluedDataPoint, voltage_a) == 3 * sizeof(float), "BluedDataPoint must match the column order");
 
 void BluedHdf5InputSource::startReading(const std::string &file_path) {
     this->startReading(file_path, []() {});
 }
 
 void BluedHdf5InputSource::startReading(const std::string &file_path, std::function<void()> callback) {
+    this->startReadingDataPoints(file_path, 0, std::numeric_limits<hsize_t>::max(), callback);
+}
+
+void BluedHdf5InputSource::startReadingTimeRange(const std::string &file_path, DynamicStreamMetaData::TimeType begin_time,
+                                                 DynamicStreamMetaData::TimeType end_time,
+                                                 std::function<void()> callback) {
+    auto data_set_start_time = boost::posix_time::time_from_string(
+            this->meta_data.getFixedPowerMetaData().data_set_start_time);
+    const double microseconds_per_second = 1000 * 1000;
+    BluedHdf5TimeIndex index(file_path);
+    hsize_t first_data_point = index.findDataPoint((begin_time - data_set_start_time).total_microseconds() /
+                                                   microseconds_per_second);
+    hsize_t end_data_point = index.findDataPoint((end_time - data_set_start_time).total_microseconds() /
+                                                 microseconds_per_second);
+    this->startReadingDataPoints(file_path, first_data_point, end_data_point, callback);
+}
+
+void BluedHdf5InputSource::startReadingDataPoints(const std::string &file_path, hsize_t first_data_point,
+                                                  hsize_t end_data_point, std::function<void()> callback) {
     this->continue_reading = true;
+    this->first_row = first_data_point;
+    this->end_row = std::max(first_data_point, end_data_point);
     auto runner_function = std::bind(&BluedHdf5InputSource::run, this, file_path, callback);
     this->initStartValues();
     this->runner = std::thread(runner_function);
 }
 
 void BluedHdf5InputSource::run(const std::string &file_path, std::function<void()> callback) {
-    using namespace H5;
-    H5File file(file_path, H5F_ACC_RDONLY);
-    DataSet dataset = file.openDataSet("data");
-    DataSpace dataspace = dataset.getSpace();
-
-    int rank = dataspace.getSimpleExtentNdims();
-    if (rank != 2) {
-        throw std::exception();
+    std::thread prefetcher(&BluedHdf5InputSource::prefetch, this, file_path);
+
+    hsize_t data_points_added = 0;
+    unsigned int current_block = 0;
+    bool last_block = false;
+    while (this->continue_reading && !last_block) {
+        Block &block = this->blocks[current_block];
+        {
+            std::unique_lock<std::mutex> lock(this->blocks_mutex);
+            this->block_filled.wait(lock, [&block, this]() {
+                return block.filled || this->prefetch_exception;
+            });
+            if (this->prefetch_exception) {
+                break;
+            }
+        }
+
+        this->data_manager.addDataPoints(block.data_points.begin(), block.data_points.begin() + block.size);
+        data_points_added += block.size;
+        if (block.size > 0) {
+            updateDynamicStreamMetaData(data_points_added - 1, block.data_points[block.size - 1]);
+        }
+        last_block = block.last;
+
+        {
+            std::lock_guard<std::mutex> lock(this->blocks_mutex);
+            block.filled = false;
+        }
+        this->block_emptied.notify_one();
+        current_block = 1 - current_block;
     }
 
-    dataspace.getSimpleExtentDims(this->data_set_size, NULL);
-    if (this->data_set_size[1] != this->fields) {
-        throw std::exception();
+    {
+        std::lock_guard<std::mutex> lock(this->blocks_mutex);
+        this->stop_prefetching = true;
+    }
+    this->block_emptied.notify_one();
+    prefetcher.join();
+    if (this->prefetch_exception) {
+        std::rethrow_exception(this->prefetch_exception);
     }
-    while (this->continue_reading) { this->readOnce(dataset, dataspace); }
+
     this->data_manager.notifyStreamEnd();
     callback();
 
 }
 
-
-bool BluedHdf5InputSource::readOnce(H5::DataSet dataset, H5::DataSpace &dataspace) {
-    if (!this->continue_reading) {
-        return false;
+void BluedHdf5InputSource::prefetch(const std::string &file_path) {
+    using namespace H5;
+    try {
+        H5File file(file_path, H5F_ACC_RDONLY);
+        DataSet dataset = file.openDataSet("data");
+        DataSpace dataspace = dataset.getSpace();
+
+        int rank = dataspace.getSimpleExtentNdims();
+        if (rank != 2) {
+            std::cerr << "The data set in " << file_path << " has to have two dimensions" << std::endl;
+            throw std::exception();
+        }
+
+        dataspace.getSimpleExtentDims(this->data_set_size, NULL);
+        if (this->data_set_size[1] != this->fields) {
+            std::cerr << "The data set in " << file_path << " has to have " << this->fields << " columns" << std::endl;
+            throw std::exception();
+        }
+        this->end_row = std::min(this->end_row, this->data_set_size[0]);
+        this->current_offset[0] = std::min(this->current_offset[0], this->end_row);
+
+        // read whole chunks, so no chunk has to be decoded twice
+        this->rows_per_block = std::max<hsize_t>(this->rows_per_read, 1);
+        DSetCreatPropList creation_properties = dataset.getCreatePlist();
+        if (creation_properties.getLayout() == H5D_CHUNKED) {
+            hsize_t chunk_dimensions[2];
+            creation_properties.getChunk(2, chunk_dimensions);
+            this->rows_per_block = (this->rows_per_block + chunk_dimensions[0] - 1) / chunk_dimensions[0] * chunk_dimensions[0];
+        }
+
+        unsigned int current_block = 0;
+        bool last_block = false;
+        while (!last_block) {
+            Block &block = this->blocks[current_block];
+            {
+                std::unique_lock<std::mutex> lock(this->blocks_mutex);
+                this->block_emptied.wait(lock, [&block, this]() {
+                    return !block.filled || this->stop_prefetching;
+                });
+                if (this->stop_prefetching) {
+                    return;
+                }
+            }
+
+            last_block = readBlock(dataset, dataspace, block);
+
+            {
+                std::lock_guard<std::mutex> lock(this->blocks_mutex);
+                block.filled = true;
+            }
+            this->block_filled.notify_one();
+            current_block = 1 - current_block;
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(this->blocks_mutex);
+        this->prefetch_exception = std::current_exception();
+        this->block_filled.notify_one();
     }
-    hsize_t read_count = this->buffer_size;
-    if (this->buffer_size > this->data_set_size[0] - this->current_offset[0]) {
-        read_count = this->data_set_size[0] - this->current_offset[0];
-        this->continue_reading = false;
+}
+
+bool BluedHdf5InputSource::readBlock(H5::DataSet &dataset, H5::DataSpace &dataspace, Block &block) {
+    hsize_t read_count = std::min(this->rows_per_block, this->end_row - this->current_offset[0]);
+    block.data_points.resize(this->rows_per_block);
+    block.size = read_count;
+    block.last = this->current_offset[0] + read_count >= this->end_row;
+    if (read_count == 0) {
+        return block.last;
     }
 
     hsize_t count[2] = {read_count, this->data_set_size[1]};
-    dataspace.selectHyperslab(H5S_SELECT_SET, count, current_offset);
-    hsize_t offset_out[2] = {0, 0};
-    this->memspace.selectHyperslab(H5S_SELECT_SET, count, offset_out);
-
-    dataset.read(this->buffer, H5::PredType::NATIVE_FLOAT, this->memspace, dataspace);
-    writeBufferToDataSet(count[0]);
-    current_offset[0] += count[0];
-    return this->continue_reading;
+    dataspace.selectHyperslab(H5S_SELECT_SET, count, this->current_offset);
+    H5::DataSpace memspace(2, count);
 
+    dataset.read(block.data_points.data(), H5::PredType::NATIVE_FLOAT, memspace, dataspace);
+    this->current_offset[0] += read_count;
+    return block.last;
 }
 
 void BluedHdf5InputSource::stopNow() {
@@ -70,29 +184,19 @@ void BluedHdf5InputSource::stopGracefully() {
     }
 }
 
-void BluedHdf5InputSource::updateDynamicStreamMetaData(BluedDataPoint to_update) {
-    DynamicStreamMetaData::DataPointIdType dp_id(this->current_offset[0] - 1);
+void BluedHdf5InputSource::updateDynamicStreamMetaData(hsize_t data_point_id, const BluedDataPoint &to_update) {
+    DynamicStreamMetaData::DataPointIdType dp_id(data_point_id);
     DynamicStreamMetaData::USDurationType time_passed(static_cast<int64_t>(to_update.x_value * 1000 * 1000));
     this->meta_data.syncTimePoint(dp_id, this->start_time + time_passed);
 }
 
 void BluedHdf5InputSource::initStartValues() {
-    this->current_offset[0] = 0;
+    this->current_offset[0] = this->first_row;
     this->current_offset[1] = 0;
-    this->start_time = boost::posix_time::time_from_string(this->meta_data.getFixedPowerMetaData().data_set_start_time);
-}
-
-void BluedHdf5InputSource::writeBufferToDataSet(unsigned int num_data_points) {
-    BluedDataPoint tmp_buffer[buffer_size];
-    std::transform(&this->buffer[0], &this->buffer[0] + num_data_points, tmp_buffer,[](float* data_points){
-        return BluedDataPoint(data_points[0],data_points[1],data_points[2],data_points[3]);
-    });
-    this->data_manager.addDataPoints(tmp_buffer, tmp_buffer + num_data_points);
-    if(num_data_points > 0) {
-        updateDynamicStreamMetaData(tmp_buffer[num_data_points - 1]);
+    this->stop_prefetching = false;
+    this->prefetch_exception = nullptr;
+    for (auto &block: this->blocks) {
+        block.filled = false;
     }
-    
-
-
+    this->start_time = boost::posix_time::time_from_string(this->meta_data.getFixedPowerMetaData().data_set_start_time);
 }
-
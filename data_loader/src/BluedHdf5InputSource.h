@@ -3,17 +3,43 @@
 
 #include <functional>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <vector>
+#include <atomic>
 #include "DynamicStreamMetaData.h"
 #include <H5Cpp.h>
 
 #include "BluedDefinitions.h"
 
+/**
+ * @brief Streams the data points of a BLUED HDF5 file, as written by the blued_converter, into the data_manager.
+ *
+ * A prefetch thread reads blocks of rows_per_read rows while the previous block is added to the data_manager, so reading
+ * the file and waiting for room in the queue overlap. The rows are read directly into BluedDataPoint memory.
+ */
 class BluedHdf5InputSource {
 public:
 
     void startReading(const std::string &file_path);
     void startReading(const std::string &file_path, std::function<void()> callback);
 
+    /**
+     * @brief Reads the data points [first_data_point, end_data_point) of the file.
+     *
+     * The data point ids in the meta_data start at 0 with first_data_point, like the ids the EventDetector counts.
+     */
+    void startReadingDataPoints(const std::string &file_path, hsize_t first_data_point, hsize_t end_data_point,
+                                std::function<void()> callback = []() {});
+
+    /**
+     * @brief Reads the data points recorded in [begin_time, end_time). The position in the file is looked up with a
+     * BluedHdf5TimeIndex. The times are relative to the data_set_start_time of the fixed PowerMetaData.
+     */
+    void startReadingTimeRange(const std::string &file_path, DynamicStreamMetaData::TimeType begin_time,
+                               DynamicStreamMetaData::TimeType end_time, std::function<void()> callback = []() {});
+
     void stopNow();
 
     void stopGracefully();
@@ -27,30 +53,48 @@ public:
 public:
     BluedDataManager data_manager;
     DynamicStreamMetaData meta_data;
+    /**
+     * @brief Number of rows that are read from the file at once. It is rounded up to whole chunks of the data set.
+     */
+    unsigned long rows_per_read = 1ul << 16;
 
 
 private:
+    struct Block {
+        std::vector<BluedDataPoint> data_points;
+        hsize_t size = 0;
+        bool filled = false;
+        bool last = false;
+    };
+
     void run(const std::string &file_path, std::function<void()> callback);
 
-    bool readOnce(H5::DataSet dataset, H5::DataSpace &dataspace);
-    void updateDynamicStreamMetaData(BluedDataPoint to_update);
+    void prefetch(const std::string &file_path);
+
+    bool readBlock(H5::DataSet &dataset, H5::DataSpace &dataspace, Block &block);
+
+    void updateDynamicStreamMetaData(hsize_t data_point_id, const BluedDataPoint &to_update);
     void initStartValues();
-    void writeBufferToDataSet(unsigned int num_data_points);
 
 private:
-    bool continue_reading = true;
+    std::atomic<bool> continue_reading{true};
     std::thread runner;
     hsize_t data_set_size[2];
     hsize_t current_offset[2];
-    static const unsigned int buffer_size = 1000;
+    hsize_t rows_per_block = 0;
+    hsize_t first_row = 0;
+    hsize_t end_row = 0;
     static const int fields = 4;
 
-    float buffer[buffer_size][fields];
-    DynamicStreamMetaData::TimeType start_time;
-
-    hsize_t mem_space_dimensions[2] = {buffer_size, fields};
+    // the prefetch thread fills one block while the runner adds the other one to the data_manager
+    Block blocks[2];
+    std::mutex blocks_mutex;
+    std::condition_variable block_filled;
+    std::condition_variable block_emptied;
+    bool stop_prefetching = false;
+    std::exception_ptr prefetch_exception;
 
-    H5::DataSpace memspace = H5::DataSpace(2, mem_space_dimensions);
+    DynamicStreamMetaData::TimeType start_time;
 
 };
 
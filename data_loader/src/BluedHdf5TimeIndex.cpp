@@ -0,0 +1,84 @@
+#include "BluedHdf5TimeIndex.h"
+
+#include <algorithm>
+#include <iostream>
+#include <exception>
+
+BluedHdf5TimeIndex::BluedHdf5TimeIndex(const std::string &file_path) : file(file_path, H5F_ACC_RDONLY) {
+    this->dataset = this->file.openDataSet("data");
+    H5::DataSpace dataspace = this->dataset.getSpace();
+    if (dataspace.getSimpleExtentNdims() != 2) {
+        std::cerr << "The data set in " << file_path << " has to have two dimensions" << std::endl;
+        throw std::exception();
+    }
+    hsize_t dimensions[2];
+    dataspace.getSimpleExtentDims(dimensions, NULL);
+    this->number_of_data_points = dimensions[0];
+    loadIndex();
+}
+
+void BluedHdf5TimeIndex::loadIndex() {
+    if (H5Lexists(this->file.getId(), indexDataSetName(), H5P_DEFAULT) <= 0) {
+        return;
+    }
+    H5::DataSet index_dataset = this->file.openDataSet(indexDataSetName());
+    H5::DataSpace index_space = index_dataset.getSpace();
+    hsize_t dimensions[2];
+    index_space.getSimpleExtentDims(dimensions, NULL);
+    if (index_space.getSimpleExtentNdims() != 2 || dimensions[1] != 2) {
+        std::cerr << "Ignoring the malformed time index" << std::endl;
+        return;
+    }
+
+    std::vector<double> entries(dimensions[0] * 2);
+    index_dataset.read(entries.data(), H5::PredType::NATIVE_DOUBLE);
+    this->index_rows.reserve(dimensions[0]);
+    this->index_x_values.reserve(dimensions[0]);
+    for (hsize_t i = 0; i < dimensions[0]; ++i) {
+        this->index_rows.push_back(static_cast<hsize_t>(entries[2 * i]));
+        this->index_x_values.push_back(entries[2 * i + 1]);
+    }
+}
+
+void BluedHdf5TimeIndex::readXValues(hsize_t first_data_point, hsize_t count, std::vector<float> &x_values) {
+    x_values.resize(count);
+    if (count == 0) {
+        return;
+    }
+    H5::DataSpace dataspace = this->dataset.getSpace();
+    hsize_t offset[2] = {first_data_point, 0};
+    hsize_t selection[2] = {count, 1};
+    dataspace.selectHyperslab(H5S_SELECT_SET, selection, offset);
+    H5::DataSpace memspace(2, selection);
+    this->dataset.read(x_values.data(), H5::PredType::NATIVE_FLOAT, memspace, dataspace);
+}
+
+hsize_t BluedHdf5TimeIndex::findDataPoint(double x_value) {
+    hsize_t first = 0;
+    hsize_t last = this->number_of_data_points;
+    if (this->hasIndex()) {
+        // narrow the search down to the interval between two index entries
+        auto upper = std::upper_bound(this->index_x_values.begin(), this->index_x_values.end(), x_value);
+        if (upper != this->index_x_values.begin()) {
+            first = this->index_rows[upper - this->index_x_values.begin() - 1];
+        }
+        if (upper != this->index_x_values.end()) {
+            last = std::min(last, this->index_rows[upper - this->index_x_values.begin()] + 1);
+        }
+        std::vector<float> x_values;
+        readXValues(first, last - first, x_values);
+        return first + (std::lower_bound(x_values.begin(), x_values.end(), x_value) - x_values.begin());
+    }
+
+    std::vector<float> x_values;
+    while (first < last) {
+        hsize_t middle = first + (last - first) / 2;
+        readXValues(middle, 1, x_values);
+        if (x_values[0] < x_value) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
@@ -0,0 +1,55 @@
+#ifndef SMART_SCREEN_BLUEDHDF5TIMEINDEX_H
+#define SMART_SCREEN_BLUEDHDF5TIMEINDEX_H
+
+#include <string>
+#include <vector>
+#include <H5Cpp.h>
+
+/**
+ * @brief Finds the data points of a BLUED HDF5 file by their x_value, the seconds since the start of the data set.
+ *
+ * The blued_converter stores a "time_index" data set next to the data. It holds the row and the x_value of every
+ * time_index_interval-th data point, so a lookup reads the index and at most one interval of x_values. Files without the index
+ * are searched with a binary search over the x_values of the data set.
+ */
+class BluedHdf5TimeIndex {
+public:
+    explicit BluedHdf5TimeIndex(const std::string &file_path);
+
+    /**
+     * @brief Returns the first data point whose x_value is not less than x_value or numberOfDataPoints if there is none.
+     */
+    hsize_t findDataPoint(double x_value);
+
+    hsize_t numberOfDataPoints() const {
+        return this->number_of_data_points;
+    }
+
+    bool hasIndex() const {
+        return !this->index_rows.empty();
+    }
+
+    static const char *indexDataSetName() {
+        return "time_index";
+    }
+
+public:
+    enum {
+        time_index_interval = 12000 /**< Distance in data points between two entries of the index, one second of BLUED data. */
+    };
+
+private:
+    void loadIndex();
+
+    void readXValues(hsize_t first_data_point, hsize_t count, std::vector<float> &x_values);
+
+private:
+    H5::H5File file;
+    H5::DataSet dataset;
+    hsize_t number_of_data_points = 0;
+
+    std::vector<hsize_t> index_rows;
+    std::vector<double> index_x_values;
+};
+
+#endif //SMART_SCREEN_BLUEDHDF5TIMEINDEX_H
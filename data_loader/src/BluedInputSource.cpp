@@ -1,4 +1,6 @@
 #include "BluedInputSource.h"
+#include "BluedTextParser.h"
+#include "MappedFile.h"
 
 #include <fstream>
 #include <regex>
@@ -6,6 +8,11 @@
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <iomanip>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
 
 void BluedInputSource::startReading(const std::string &file_path) {
     this->startReading(file_path, []() {});
@@ -70,11 +77,15 @@ void BluedInputSource::readWholeLocation(const std::string &directory, std::func
 
 void BluedInputSource::runLocations(std::vector<std::string> locations, std::function<void()> callback) {
     this->data_manager.restartStreaming();
-    for (auto &file_path : locations) {
-        if (!this->continue_reading) {
-            break;
+    if (this->number_of_parser_threads > 1 && this->parser_mode == BluedParserMode::MemoryMapped) {
+        readLocationsInParallel(locations);
+    } else {
+        for (auto &file_path : locations) {
+            if (!this->continue_reading) {
+                break;
+            }
+            readFile(file_path);
         }
-        readFile(file_path);
     }
     this->data_manager.notifyStreamEnd();
     callback();
@@ -94,16 +105,7 @@ BluedDataPoint BluedInputSource::matchLine(std::ifstream &input_stream) {
     double x_value;
     input_stream >> x_value;
     input_stream.ignore(50, ',');
-    const double x_value_max_dist = 0.0001;
-    if(x_value < previous_x_value || x_value > previous_x_value + x_value_max_dist) {
-        if(previous_x_value > -100.f) {
-            std::cerr << std::setprecision(9) << "The distance between the x_values is not within the bounds\nprevious value: "
-                      << previous_x_value << "\ncurrent value: " << x_value
-                      << "\ncurrent - prev: " <<x_value -  previous_x_value<< std::endl;
-            throw std::exception();
-        }
-    }
-    previous_x_value = x_value;
+    checkXValue(x_value);
 
     float current_a;
     input_stream >> current_a;
@@ -124,6 +126,19 @@ BluedDataPoint BluedInputSource::matchLine(std::ifstream &input_stream) {
     return BluedDataPoint(static_cast<float>(x_value), current_a, current_b, voltage_a);
 }
 
+void BluedInputSource::checkXValue(double x_value, double &last_x_value) {
+    const double x_value_max_dist = 0.0001;
+    if(x_value < last_x_value || x_value > last_x_value + x_value_max_dist) {
+        if(last_x_value > -100.f) {
+            std::cerr << std::setprecision(9) << "The distance between the x_values is not within the bounds\nprevious value: "
+                      << last_x_value << "\ncurrent value: " << x_value
+                      << "\ncurrent - prev: " <<x_value -  last_x_value<< std::endl;
+            throw std::exception();
+        }
+    }
+    last_x_value = x_value;
+}
+
 bool BluedInputSource::readOnce(std::ifstream &input_stream) {
     const unsigned int buffer_size = 10000;
 
@@ -132,7 +147,10 @@ bool BluedInputSource::readOnce(std::ifstream &input_stream) {
     unsigned int i = 0;
     for (; i < buffer_size; ++i) {
         if (!(input_stream.good() && this->continue_reading)) {
-            --i;
+            // the last line was read from a failing stream, with i == 0 it belongs to the previous buffer
+            if (i > 0) {
+                --i;
+            }
             success = false;
             break;
 
@@ -157,6 +175,10 @@ bool BluedInputSource::skipToData(std::ifstream &input_stream) {
 }
 
 void BluedInputSource::readFile(const std::string &file_path) {
+    if (this->parser_mode == BluedParserMode::MemoryMapped) {
+        readMappedFile(file_path);
+        return;
+    }
     std::ifstream input_stream;
     input_stream.open(file_path, std::ifstream::in);
 
@@ -170,3 +192,159 @@ void BluedInputSource::readFile(const std::string &file_path) {
     }
 }
 
+void BluedInputSource::readMappedFile(const std::string &file_path) {
+    double first_x_value;
+    parseMappedFile(file_path, this->previous_x_value, first_x_value,
+                    [this](std::vector<BluedDataPoint>::const_iterator begin, std::vector<BluedDataPoint>::const_iterator end) {
+                        this->data_manager.addDataPoints(begin, end);
+                    });
+}
+
+template<typename EmitFunctionType> void
+BluedInputSource::parseMappedFile(const std::string &file_path, double &last_x_value, double &first_x_value,
+                                  EmitFunctionType emit) {
+    MappedFile file(file_path);
+    file.adviseSequential();
+    const char *end = file.data() + file.size();
+    const char *position = BluedTextParser::skipToData(file.data(), end);
+    if (position == nullptr) {
+        std::cerr << "The file could not be opened: " << file_path << std::endl;
+
+        throw std::exception();
+    }
+
+    const unsigned int buffer_size = 10000;
+    std::vector<BluedDataPoint> buffer(buffer_size);
+    bool first_row = true;
+    while (position != end && this->continue_reading) {
+        unsigned int i = 0;
+        while (i < buffer_size && position != end) {
+            const char *row = position;
+            double x_value;
+            if (BluedTextParser::parseRow(position, end, x_value, buffer[i])) {
+                checkXValue(x_value, last_x_value);
+                if (first_row) {
+                    first_x_value = x_value;
+                    first_row = false;
+                }
+                ++i;
+            } else if (*row == '\r' || *row == '\n') {
+                // empty lines, like the one at the end of the file, are skipped
+                position = row;
+                BluedTextParser::skipLine(position, end);
+            } else {
+                std::cerr << "Could not parse line " << std::string(row, std::find(row, end, '\n'))
+                          << " in " << file_path << std::endl;
+                throw std::exception();
+            }
+        }
+        emit(buffer.cbegin(), buffer.cbegin() + i);
+    }
+}
+
+void BluedInputSource::readLocationsInParallel(const std::vector<std::string> &locations) {
+    struct ParsedFile {
+        std::vector<BluedDataPoint> data_points;
+        double first_x_value = 0;
+        double last_x_value = -1000;
+        std::exception_ptr error;
+        bool done = false;
+    };
+
+    // files are parsed at most this far ahead of the one that is added to the data_manager, which bounds the memory
+    const unsigned long files_ahead = 2 * this->number_of_parser_threads;
+    std::vector<ParsedFile> parsed_files(locations.size());
+    std::mutex files_mutex;
+    std::condition_variable file_parsed;
+    std::condition_variable file_emitted;
+    unsigned long next_file_to_emit = 0;
+    bool stop_parsing = false;
+    std::atomic<unsigned long> next_file_to_parse{0};
+
+    auto parse_files = [&]() {
+        while (true) {
+            unsigned long file = next_file_to_parse++;
+            if (file >= locations.size()) {
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(files_mutex);
+                file_emitted.wait(lock, [&]() {
+                    return file < next_file_to_emit + files_ahead || stop_parsing;
+                });
+                if (stop_parsing) {
+                    return;
+                }
+            }
+            ParsedFile &parsed_file = parsed_files[file];
+            try {
+                // the continuity inside the file is checked here, the one to the previous file when it is emitted
+                parseMappedFile(locations[file], parsed_file.last_x_value, parsed_file.first_x_value,
+                                [&parsed_file](std::vector<BluedDataPoint>::const_iterator begin,
+                                               std::vector<BluedDataPoint>::const_iterator end) {
+                                    parsed_file.data_points.insert(parsed_file.data_points.end(), begin, end);
+                                });
+            } catch (...) {
+                parsed_file.error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(files_mutex);
+            parsed_file.done = true;
+            file_parsed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> parsers;
+    for (unsigned int i = 0; i < this->number_of_parser_threads; ++i) {
+        parsers.emplace_back(parse_files);
+    }
+
+    std::exception_ptr error;
+    for (unsigned long file = 0; file < locations.size() && this->continue_reading; ++file) {
+        ParsedFile &parsed_file = parsed_files[file];
+        {
+            std::unique_lock<std::mutex> lock(files_mutex);
+            file_parsed.wait(lock, [&parsed_file]() {
+                return parsed_file.done;
+            });
+        }
+        if (parsed_file.error) {
+            error = parsed_file.error;
+            break;
+        }
+        if (!parsed_file.data_points.empty()) {
+            try {
+                checkXValue(parsed_file.first_x_value);
+            } catch (...) {
+                error = std::current_exception();
+                break;
+            }
+            this->previous_x_value = parsed_file.last_x_value;
+        }
+
+        const unsigned long batch_size = 10000;
+        for (auto begin = parsed_file.data_points.cbegin();
+             begin != parsed_file.data_points.cend() && this->continue_reading;) {
+            auto end = begin + std::min<long>(batch_size, parsed_file.data_points.cend() - begin);
+            this->data_manager.addDataPoints(begin, end);
+            begin = end;
+        }
+        std::vector<BluedDataPoint>().swap(parsed_file.data_points);
+
+        std::lock_guard<std::mutex> lock(files_mutex);
+        next_file_to_emit = file + 1;
+        file_emitted.notify_all();
+    }
+
+    {
+        // wake parsers that wait for room, the remaining files are not needed anymore
+        std::lock_guard<std::mutex> lock(files_mutex);
+        stop_parsing = true;
+        file_emitted.notify_all();
+    }
+    for (auto &parser: parsers) {
+        parser.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
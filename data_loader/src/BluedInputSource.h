@@ -7,6 +7,13 @@
 
 #include "BluedDefinitions.h"
 
+namespace BluedParserMode {
+    enum BluedParserMode {
+        Stream, /**< The files are read with std::ifstream and its number extraction. */
+        MemoryMapped /**< The files are memory mapped and parsed by the BluedTextParser. */
+    };
+}
+
 class BluedInputSource {
 
 
@@ -30,6 +37,12 @@ public:
 
 public:
     BluedDataManager data_manager;
+    BluedParserMode::BluedParserMode parser_mode = BluedParserMode::MemoryMapped;
+    /**
+     * @brief With more than one thread readWholeLocation parses several files at once. The data points are still added to the
+     * data_manager in the order of the files. Only used with BluedParserMode::MemoryMapped.
+     */
+    unsigned int number_of_parser_threads = 1;
 
 
 private:
@@ -37,8 +50,21 @@ private:
 
     void readFile(const std::string &file_path);
 
+    void readMappedFile(const std::string &file_path);
+
+    template<typename EmitFunctionType> void
+    parseMappedFile(const std::string &file_path, double &last_x_value, double &first_x_value, EmitFunctionType emit);
+
+    void checkXValue(double x_value) {
+        checkXValue(x_value, this->previous_x_value);
+    }
+
+    static void checkXValue(double x_value, double &last_x_value);
+
     void runLocations(std::vector<std::string> locations, std::function<void()> callback);
 
+    void readLocationsInParallel(const std::vector<std::string> &locations);
+
     BluedDataPoint matchLine(std::ifstream &input_stream);
 
     bool readOnce(std::ifstream &input_stream);
@@ -48,6 +74,7 @@ private:
 private:
     bool continue_reading = true;
     std::thread runner;
+    // while it is below -100 the next x_value is not checked
     double previous_x_value = -1000;
 };
 
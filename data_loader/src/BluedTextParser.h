@@ -0,0 +1,195 @@
+#ifndef SMART_SCREEN_BLUEDTEXTPARSER_H
+#define SMART_SCREEN_BLUEDTEXTPARSER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "BluedDataPoint.h"
+
+/**
+ * @brief Parses the rows of BLUED text files directly from memory.
+ *
+ * The numbers are scanned by hand instead of with stream extraction, so no locale is involved. Numbers with up to 15 significant
+ * digits and a decimal exponent of at most 22 are converted exactly with one multiplication or division, which covers all values
+ * of the BLUED data set. Longer numbers are passed on to strtod.
+ */
+class BluedTextParser {
+public:
+    /**
+     * @brief Returns the position of the first row after the header or nullptr if the header is missing.
+     */
+    static const char *skipToData(const char *position, const char *end);
+
+    /**
+     * @brief Parses one "X_Value,Current A,Current B,VoltageA,Comment" row and moves position to the start of the next row.
+     *
+     * @return Returns false if the row could not be parsed.
+     */
+    static bool parseRow(const char *&position, const char *end, double &x_value, BluedDataPoint &data_point);
+
+    /**
+     * @brief Moves position behind the next line break.
+     */
+    static void skipLine(const char *&position, const char *end) {
+        const char *line_end = static_cast<const char *>(std::memchr(position, '\n', end - position));
+        position = line_end == nullptr ? end : line_end + 1;
+    }
+
+    static bool parseNumber(const char *&position, const char *end, double &value);
+
+private:
+    static bool parseField(const char *&position, const char *end, double &value);
+
+    static bool parseNumberWithStrtod(const char *begin, const char *end, double &value);
+
+    static bool isDigit(char c) {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+private:
+    enum {
+        max_exact_digits = 15,
+        max_exact_exponent = 22,
+        max_number_length = 63
+    };
+};
+
+inline const char *BluedTextParser::skipToData(const char *position, const char *end) {
+    static const char header[] = "X_Value,Current A,Current B,VoltageA,Comment";
+    const char *header_begin = std::search(position, end, header, header + sizeof(header) - 1);
+    if (header_begin == end) {
+        return nullptr;
+    }
+    position = header_begin;
+    skipLine(position, end);
+    return position;
+}
+
+inline bool
+BluedTextParser::parseRow(const char *&position, const char *end, double &x_value, BluedDataPoint &data_point) {
+    double current_a;
+    double current_b;
+    double voltage_a;
+    if (!(parseField(position, end, x_value) && parseField(position, end, current_a) &&
+          parseField(position, end, current_b) && parseNumber(position, end, voltage_a))) {
+        return false;
+    }
+    // the comment column is ignored
+    skipLine(position, end);
+
+    data_point.x_value = static_cast<float>(x_value);
+    data_point.current_a = static_cast<float>(current_a);
+    data_point.current_b = static_cast<float>(current_b);
+    data_point.voltage_a = static_cast<float>(voltage_a);
+    return true;
+}
+
+inline bool BluedTextParser::parseField(const char *&position, const char *end, double &value) {
+    if (!parseNumber(position, end, value) || position == end || *position != ',') {
+        return false;
+    }
+    ++position;
+    return true;
+}
+
+inline bool BluedTextParser::parseNumber(const char *&position, const char *end, double &value) {
+    static const double powers_of_ten[max_exact_exponent + 1] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    const char *current = position;
+    while (current != end && (*current == ' ' || *current == '\t')) {
+        ++current;
+    }
+    const char *number_begin = current;
+
+    bool negative = false;
+    if (current != end && (*current == '-' || *current == '+')) {
+        negative = *current == '-';
+        ++current;
+    }
+
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    for (; current != end && isDigit(*current); ++current) {
+        has_digits = true;
+        if (mantissa == 0 && *current == '0') {
+            continue;
+        }
+        if (significant_digits < max_exact_digits) {
+            mantissa = mantissa * 10 + (*current - '0');
+        } else {
+            ++exponent;
+        }
+        ++significant_digits;
+    }
+    if (current != end && *current == '.') {
+        ++current;
+        for (; current != end && isDigit(*current); ++current) {
+            has_digits = true;
+            if (mantissa == 0 && *current == '0') {
+                --exponent;
+                continue;
+            }
+            if (significant_digits < max_exact_digits) {
+                mantissa = mantissa * 10 + (*current - '0');
+                --exponent;
+            }
+            ++significant_digits;
+        }
+    }
+    if (!has_digits) {
+        return false;
+    }
+    if (current != end && (*current == 'e' || *current == 'E')) {
+        const char *exponent_position = current + 1;
+        bool negative_exponent = false;
+        if (exponent_position != end && (*exponent_position == '-' || *exponent_position == '+')) {
+            negative_exponent = *exponent_position == '-';
+            ++exponent_position;
+        }
+        if (exponent_position != end && isDigit(*exponent_position)) {
+            int written_exponent = 0;
+            for (; exponent_position != end && isDigit(*exponent_position); ++exponent_position) {
+                written_exponent = std::min(written_exponent * 10 + (*exponent_position - '0'), 100000);
+            }
+            exponent += negative_exponent ? -written_exponent : written_exponent;
+            current = exponent_position;
+        }
+    }
+
+    if (mantissa == 0) {
+        value = negative ? -0.0 : 0.0;
+    } else if (significant_digits > max_exact_digits || exponent > max_exact_exponent ||
+               exponent < -max_exact_exponent) {
+        if (!parseNumberWithStrtod(number_begin, current, value)) {
+            return false;
+        }
+    } else {
+        // both operands are exact doubles, so the result is correctly rounded
+        value = exponent < 0 ? mantissa / powers_of_ten[-exponent] : mantissa * powers_of_ten[exponent];
+        if (negative) {
+            value = -value;
+        }
+    }
+    position = current;
+    return true;
+}
+
+inline bool BluedTextParser::parseNumberWithStrtod(const char *begin, const char *end, double &value) {
+    if (end - begin > max_number_length) {
+        return false;
+    }
+    // the mapped file is not null terminated
+    char number[max_number_length + 1];
+    std::copy(begin, end, number);
+    number[end - begin] = '\0';
+    value = std::strtod(number, nullptr);
+    return true;
+}
+
+#endif //SMART_SCREEN_BLUEDTEXTPARSER_H
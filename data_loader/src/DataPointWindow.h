@@ -0,0 +1,28 @@
+#ifndef SMART_SCREEN_DATAPOINTWINDOW_H
+#define SMART_SCREEN_DATAPOINTWINDOW_H
+
+/**
+ * @brief A read only view on contiguous data points that are still owned by an AsyncDataQueue.
+ *
+ * The view does not copy anything. It stays valid until the reader removes data points from the queue again.
+ */
+template<typename DataPointType> class DataPointWindow {
+public:
+    DataPointWindow() : window_begin(nullptr), window_end(nullptr) {}
+
+    DataPointWindow(const DataPointType *begin, const DataPointType *end) : window_begin(begin), window_end(end) {}
+
+    const DataPointType *begin() const { return window_begin; }
+
+    const DataPointType *end() const { return window_end; }
+
+    unsigned long size() const { return static_cast<unsigned long>(window_end - window_begin); }
+
+    bool empty() const { return window_begin == window_end; }
+
+private:
+    const DataPointType *window_begin;
+    const DataPointType *window_end;
+};
+
+#endif //SMART_SCREEN_DATAPOINTWINDOW_H
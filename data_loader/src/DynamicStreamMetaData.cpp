@@ -1,29 +1,134 @@
 #include "DynamicStreamMetaData.h"
 
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// stored for sync points without a valid time, like not_a_date_time
+static const int64_t invalid_time = std::numeric_limits<int64_t>::min();
+
 void DynamicStreamMetaData::syncTimePoint(DynamicStreamMetaData::DataPointIdType data_point_number,
                                           DynamicStreamMetaData::TimeType time) {
     std::lock_guard<std::mutex> time_lock(sync_mutex);
-    this->synced_package_id = data_point_number;
-    this->packet_time = time;
+    const int64_t microseconds = timeToMicroseconds(time);
+
+    // readers that see an odd sequence or a sequence that changed while they read retry
+    const uint64_t current_sequence = this->sequence.load(std::memory_order_relaxed);
+    this->sequence.store(current_sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t stored = this->stored_sync_points.load(std::memory_order_relaxed);
+    unsigned int newest = (stored + time_sync_points - 1) % time_sync_points;
+    DataPointIdType newest_id = stored > 0 ? this->sync_point_ids[newest].load(std::memory_order_relaxed) : 0;
+    if (stored > 0 && data_point_number == newest_id) {
+        this->sync_point_times[newest].store(microseconds, std::memory_order_relaxed);
+    } else {
+        if (data_point_number < newest_id) {
+            stored = 0;
+        }
+        unsigned int slot = stored % time_sync_points;
+        this->sync_point_ids[slot].store(data_point_number, std::memory_order_relaxed);
+        this->sync_point_times[slot].store(microseconds, std::memory_order_relaxed);
+        this->stored_sync_points.store(stored + 1, std::memory_order_relaxed);
+    }
+
+    this->sequence.store(current_sequence + 2, std::memory_order_release);
 }
 
 DynamicStreamMetaData::TimeType
-DynamicStreamMetaData::getDataPointTime(DynamicStreamMetaData::DataPointIdType data_point_number){
-    std::lock_guard<std::mutex> time_lock(sync_mutex);
-    DataPointIdType data_point_difference = data_point_number - synced_package_id;
-    data_point_difference *= DataPointIdType(1000000);
-    data_point_difference /= DataPointIdType(power_meta_data.sample_rate);
+DynamicStreamMetaData::getDataPointTime(DynamicStreamMetaData::DataPointIdType data_point_number) const {
+    SyncPoint before;
+    SyncPoint after;
+    bool has_after = false;
+    uint64_t rate = 1;
+    if (!this->readSyncPoints(data_point_number, before, after, has_after, rate)) {
+        return TimeType();
+    }
+    if (before.time == invalid_time || (has_after && after.time == invalid_time)) {
+        return TimeType();
+    }
 
-    return this->packet_time + USDurationType(static_cast<int>(data_point_difference));
+    int64_t time_offset;
+    if (has_after) {
+        double fraction = static_cast<double>(data_point_number - before.data_point_id) /
+                          static_cast<double>(after.data_point_id - before.data_point_id);
+        time_offset = std::llround(fraction * static_cast<double>(after.time - before.time));
+    } else {
+        // the difference is negative for data points before the oldest sync point
+        int64_t data_point_difference = static_cast<int64_t>(data_point_number - before.data_point_id);
+        time_offset = data_point_difference * 1000000 / static_cast<int64_t>(std::max<uint64_t>(rate, 1));
+    }
+    return microsecondsToTime(before.time + time_offset);
+}
+
+bool DynamicStreamMetaData::readSyncPoints(DataPointIdType data_point_number, SyncPoint &before, SyncPoint &after,
+                                           bool &has_after, uint64_t &rate) const {
+    for (;;) {
+        const uint64_t begin_sequence = this->sequence.load(std::memory_order_acquire);
+        if (begin_sequence % 2 != 0) {
+            continue;
+        }
+
+        rate = this->sample_rate.load(std::memory_order_relaxed);
+        const uint64_t stored = this->stored_sync_points.load(std::memory_order_relaxed);
+        const uint64_t count = std::min<uint64_t>(stored, time_sync_points);
+        auto slot = [stored, count](uint64_t position) {
+            return static_cast<unsigned int>((stored - count + position) % time_sync_points);
+        };
+
+        // first sync point after the data point, the sync points are ordered by their ids
+        uint64_t low = 0;
+        uint64_t high = count;
+        while (low < high) {
+            uint64_t middle = low + (high - low) / 2;
+            if (this->sync_point_ids[slot(middle)].load(std::memory_order_relaxed) <= data_point_number) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        has_after = low > 0 && low < count;
+        if (count > 0) {
+            // before the oldest sync point the time is extrapolated from it
+            unsigned int before_slot = slot(low > 0 ? low - 1 : 0);
+            before.data_point_id = this->sync_point_ids[before_slot].load(std::memory_order_relaxed);
+            before.time = this->sync_point_times[before_slot].load(std::memory_order_relaxed);
+        }
+        if (has_after) {
+            after.data_point_id = this->sync_point_ids[slot(low)].load(std::memory_order_relaxed);
+            after.time = this->sync_point_times[slot(low)].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (this->sequence.load(std::memory_order_relaxed) == begin_sequence) {
+            return count > 0;
+        }
+    }
 }
 
 void DynamicStreamMetaData::setFixedPowerMetaData(PowerMetaData fixed_meta_data) {
     std::lock_guard<std::mutex> time_lock(sync_mutex);
+    this->sample_rate.store(fixed_meta_data.sample_rate, std::memory_order_relaxed);
     this->power_meta_data = fixed_meta_data;
 
 
 }
 
 PowerMetaData DynamicStreamMetaData::getFixedPowerMetaData() const {
+    std::lock_guard<std::mutex> time_lock(sync_mutex);
     return this->power_meta_data;
 }
+
+int64_t DynamicStreamMetaData::timeToMicroseconds(const TimeType &time) {
+    if (time.is_special()) {
+        return invalid_time;
+    }
+    static const TimeType epoch(boost::gregorian::date(1970, 1, 1));
+    return (time - epoch).total_microseconds();
+}
+
+DynamicStreamMetaData::TimeType DynamicStreamMetaData::microsecondsToTime(int64_t microseconds) {
+    static const TimeType epoch(boost::gregorian::date(1970, 1, 1));
+    return epoch + USDurationType(microseconds);
+}
@@ -2,35 +2,78 @@
 #define _SMART_SCREEN_DYNAMICSTREAMMETADATA_H
 
 #include <mutex>
+#include <atomic>
+#include <cstdint>
 
-#include <boost/multiprecision/cpp_int.hpp>
 #include <boost/date_time.hpp>
 #include "PowerMetaData.h"
 
 
+/**
+ * @brief Maps the ids of the data points of a stream to the time they were recorded.
+ *
+ * The producer of the stream records sync points, pairs of a data point id and its time, with syncTimePoint. The last
+ * time_sync_points of them are kept in a table. The time of a data point between two sync points is interpolated linearly,
+ * so a sample clock that drifts against the wall clock is corrected piecewise. Before the first and after the last sync point
+ * the time is extrapolated with the sample rate.
+ *
+ * getDataPointTime does not lock: the table is guarded by a sequence counter and a reader that overlaps with syncTimePoint
+ * reads it again. Concurrent calls of syncTimePoint and setFixedPowerMetaData are serialized with a mutex.
+ */
 class DynamicStreamMetaData {
 public:
-    typedef boost::multiprecision::cpp_int DataPointIdType;
+    typedef uint64_t DataPointIdType;
     typedef boost::posix_time::ptime TimeType;
     typedef boost::posix_time::milliseconds MSDurationType;
     typedef boost::posix_time::microseconds USDurationType;
 
 
-    DynamicStreamMetaData(DataPointIdType starting_package_id = 0) : synced_package_id(
-            starting_package_id){}
+    DynamicStreamMetaData() {}
     void setFixedPowerMetaData(PowerMetaData fixed_meta_data);
     PowerMetaData getFixedPowerMetaData() const;
+
+    /**
+     * @brief Records that the data point data_point_number was recorded at time. A data point number that is not larger than
+     * the one of the last sync point starts a new stream and discards the older sync points.
+     */
     void syncTimePoint(DataPointIdType data_point_number, TimeType time);
 
-    TimeType getDataPointTime(DataPointIdType data_point_number);
+    /**
+     * @brief Returns the time of the data point, not_a_date_time if no time point was synced yet.
+     */
+    TimeType getDataPointTime(DataPointIdType data_point_number) const;
+
+
+private:
+    enum {
+        time_sync_points = 64
+    };
+
+    struct SyncPoint {
+        DataPointIdType data_point_id;
+        // microseconds since the unix epoch
+        int64_t time;
+    };
+
+    bool readSyncPoints(DataPointIdType data_point_number, SyncPoint &before, SyncPoint &after, bool &has_after,
+                        uint64_t &sample_rate) const;
 
+    static int64_t timeToMicroseconds(const TimeType &time);
+
+    static TimeType microsecondsToTime(int64_t microseconds);
 
 private:
-    std::mutex sync_mutex;
-    DataPointIdType synced_package_id;
-    DynamicStreamMetaData::TimeType packet_time;
+    mutable std::mutex sync_mutex;
     PowerMetaData power_meta_data;
 
+    // odd while syncTimePoint changes the table
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> sample_rate{12000};
+    // number of sync points ever stored since the table was reset, the newest one is at (stored_sync_points - 1) % time_sync_points
+    std::atomic<uint64_t> stored_sync_points{0};
+    std::atomic<DataPointIdType> sync_point_ids[time_sync_points];
+    std::atomic<int64_t> sync_point_times[time_sync_points];
+
 };
 
 
@@ -0,0 +1,94 @@
+#ifndef SMART_SCREEN_MAPPEDFILE_H
+#define SMART_SCREEN_MAPPEDFILE_H
+
+#include <string>
+#include <utility>
+#include <iostream>
+#include <exception>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Read only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+    MappedFile() {}
+
+    explicit MappedFile(const std::string &file_path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept : mapped_data(other.mapped_data), mapped_size(other.mapped_size) {
+        other.mapped_data = nullptr;
+        other.mapped_size = 0;
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        std::swap(this->mapped_data, other.mapped_data);
+        std::swap(this->mapped_size, other.mapped_size);
+        return *this;
+    }
+
+    const char *data() const {
+        return this->mapped_data;
+    }
+
+    std::size_t size() const {
+        return this->mapped_size;
+    }
+
+    /**
+     * @brief Tells the kernel that the file is read front to back, so it reads ahead more aggressively.
+     */
+    void adviseSequential() const {
+        if (this->mapped_data != nullptr) {
+            ::madvise(const_cast<char *>(this->mapped_data), this->mapped_size, MADV_SEQUENTIAL);
+        }
+    }
+
+private:
+    const char *mapped_data = nullptr;
+    std::size_t mapped_size = 0;
+};
+
+inline MappedFile::MappedFile(const std::string &file_path) {
+    int file_descriptor = ::open(file_path.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
+        std::cerr << "Could not open path: " << file_path << std::endl;
+        throw std::exception();
+    }
+    struct stat file_status;
+    if (::fstat(file_descriptor, &file_status) != 0) {
+        ::close(file_descriptor);
+        std::cerr << "Could not stat path: " << file_path << std::endl;
+        throw std::exception();
+    }
+    this->mapped_size = static_cast<std::size_t>(file_status.st_size);
+    if (this->mapped_size > 0) {
+        void *mapping = ::mmap(nullptr, this->mapped_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(file_descriptor);
+            std::cerr << "Could not map path: " << file_path << std::endl;
+            throw std::exception();
+        }
+        this->mapped_data = static_cast<const char *>(mapping);
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(file_descriptor);
+}
+
+inline MappedFile::~MappedFile() {
+    if (this->mapped_data != nullptr) {
+        ::munmap(const_cast<char *>(this->mapped_data), this->mapped_size);
+    }
+}
+
+#endif //SMART_SCREEN_MAPPEDFILE_H
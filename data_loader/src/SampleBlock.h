@@ -0,0 +1,162 @@
+#ifndef SMART_SCREEN_SAMPLEBLOCK_H
+#define SMART_SCREEN_SAMPLEBLOCK_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <iostream>
+#include <exception>
+
+/**
+ * @brief Allocates memory aligned to Alignment bytes, so vectorized loops over the memory need no unaligned head.
+ */
+template<typename ValueType, std::size_t Alignment> class AlignedAllocator {
+public:
+    typedef ValueType value_type;
+
+    template<typename OtherType> struct rebind {
+        typedef AlignedAllocator<OtherType, Alignment> other;
+    };
+
+    AlignedAllocator() {}
+
+    template<typename OtherType> AlignedAllocator(const AlignedAllocator<OtherType, Alignment> &) {}
+
+    ValueType *allocate(std::size_t n) {
+        void *memory = nullptr;
+        if (::posix_memalign(&memory, Alignment, n * sizeof(ValueType)) != 0) {
+            throw std::bad_alloc();
+        }
+        return static_cast<ValueType *>(memory);
+    }
+
+    void deallocate(ValueType *memory, std::size_t) {
+        std::free(memory);
+    }
+
+    template<typename OtherType> bool operator==(const AlignedAllocator<OtherType, Alignment> &) const {
+        return true;
+    }
+
+    template<typename OtherType> bool operator!=(const AlignedAllocator<OtherType, Alignment> &) const {
+        return false;
+    }
+};
+
+/**
+ * @brief Holds the ampere and the voltage values of consecutive data points in two separate, aligned arrays.
+ *
+ * The data points of the queue and of the events store the values of one sample next to each other, so a pass over the
+ * ampere values through makeAmpereIterator loads the voltages as well and the compiler can not vectorize it. assign
+ * transposes a range of any data point type once, the analysis kernels then run on the contiguous columns.
+ */
+class SampleBlock {
+public:
+    typedef float DatumType;
+
+    enum {
+        alignment = 32
+    };
+
+    SampleBlock() {}
+
+    template<typename IteratorType> SampleBlock(IteratorType begin, IteratorType end) {
+        this->assign(begin, end);
+    }
+
+    /**
+     * @brief Replaces the samples with the ampere() and voltage() values of the data points in [begin, end). The memory of
+     * the columns is reused, so refilling a block does not allocate once it has reached its size.
+     */
+    template<typename IteratorType> void assign(IteratorType begin, IteratorType end);
+
+    /**
+     * @brief Like assign, but the ampere column holds the current of a single channel, channels()[channel], instead of the
+     * sum of all channels returned by ampere(). Used for the events of data points with several current channels.
+     */
+    template<typename IteratorType> void assign(IteratorType begin, IteratorType end, unsigned int channel);
+
+    std::size_t size() const {
+        return this->ampere_values.size();
+    }
+
+    bool empty() const {
+        return this->ampere_values.empty();
+    }
+
+    const DatumType *ampereBegin() const {
+        return this->ampere_values.data();
+    }
+
+    const DatumType *ampereEnd() const {
+        return this->ampere_values.data() + this->ampere_values.size();
+    }
+
+    const DatumType *voltageBegin() const {
+        return this->voltage_values.data();
+    }
+
+    const DatumType *voltageEnd() const {
+        return this->voltage_values.data() + this->voltage_values.size();
+    }
+
+private:
+    // only data points with channels() and number_of_channels have currents per channel
+    template<typename DataPointType> static auto
+    numberOfChannels(const DataPointType &, int) -> decltype(static_cast<unsigned int>(DataPointType::number_of_channels)) {
+        return DataPointType::number_of_channels;
+    }
+
+    template<typename DataPointType> static unsigned int numberOfChannels(const DataPointType &, long) {
+        return 0;
+    }
+
+    template<typename DataPointType> static auto
+    channelAmpere(const DataPointType &data_point, unsigned int channel, int)
+    -> decltype(static_cast<DatumType>(data_point.channels()[channel])) {
+        return data_point.channels()[channel];
+    }
+
+    template<typename DataPointType> static DatumType channelAmpere(const DataPointType &data_point, unsigned int, long) {
+        return data_point.ampere();
+    }
+
+private:
+    typedef std::vector<DatumType, AlignedAllocator<DatumType, alignment>> ColumnType;
+
+    ColumnType ampere_values;
+    ColumnType voltage_values;
+};
+
+template<typename IteratorType> void SampleBlock::assign(IteratorType begin, IteratorType end) {
+    const std::size_t number_of_samples = static_cast<std::size_t>(end - begin);
+    this->ampere_values.resize(number_of_samples);
+    this->voltage_values.resize(number_of_samples);
+
+    DatumType *ampere = this->ampere_values.data();
+    DatumType *voltage = this->voltage_values.data();
+    for (std::size_t i = 0; begin != end; ++begin, ++i) {
+        ampere[i] = begin->ampere();
+        voltage[i] = begin->voltage();
+    }
+}
+
+template<typename IteratorType> void SampleBlock::assign(IteratorType begin, IteratorType end, unsigned int channel) {
+    const std::size_t number_of_samples = static_cast<std::size_t>(end - begin);
+    if (number_of_samples > 0 && channel >= numberOfChannels(*begin, 0)) {
+        std::cerr << "The data points have no current channel " << channel << std::endl;
+        throw std::exception();
+    }
+    this->ampere_values.resize(number_of_samples);
+    this->voltage_values.resize(number_of_samples);
+
+    DatumType *ampere = this->ampere_values.data();
+    DatumType *voltage = this->voltage_values.data();
+    for (std::size_t i = 0; begin != end; ++begin, ++i) {
+        ampere[i] = channelAmpere(*begin, channel, 0);
+        voltage[i] = begin->voltage();
+    }
+}
+
+#endif //SMART_SCREEN_SAMPLEBLOCK_H
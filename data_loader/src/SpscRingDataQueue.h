@@ -0,0 +1,319 @@
+#ifndef SMART_SCREEN_SPSCRINGDATAQUEUE_H
+#define SMART_SCREEN_SPSCRINGDATAQUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <vector>
+
+#include "AsyncDataQueue.h"
+
+/**
+ * @brief AsyncDataQueue backend for exactly one writing and one reading thread.
+ *
+ * The data points are stored in a ring buffer whose capacity is the queue max size rounded up to the next power of two.
+ * Reader and writer only communicate through the read and write positions which live on separate cache lines, so a
+ * batch costs a couple of atomic loads and one store. A thread that has to wait spins for a short while and then falls
+ * back to sleeping on a condition variable. The mutex is only touched if the other side actually sleeps.
+ *
+ * setQueueMaxSize and restartStreaming must not be called while the other thread is accessing the queue.
+ * Windows returned by peekDataPoints point directly into the ring. Only a window that wraps around the end of the ring
+ * is copied into a scratch buffer owned by the reader.
+ */
+template<typename DataPointType> class AsyncDataQueue<DataPointType, SpscRingQueuePolicy> {
+public:
+    AsyncDataQueue() {
+        this->allocateRing(this->queue_max_size);
+    }
+
+    ~AsyncDataQueue() {
+        this->discardRestOfStream();
+    }
+
+    void setQueueMaxSize(unsigned long max_size);
+
+    unsigned long getQueueMaxSize();
+
+    unsigned long getQueueSize();
+
+    void restartStreaming() {
+        this->discarded = false;
+        this->stream_ended = false;
+    }
+
+    template<class IteratorType> IteratorType
+    getDataPoints(IteratorType begin, IteratorType end, unsigned long offset = 0);
+
+    DataPointWindow<DataPointType> peekDataPoints(unsigned long num_data_points, unsigned long offset = 0);
+
+    /**
+     * @brief Returns true if reading num_data_points data points would not block. Must only be called by the reading thread.
+     */
+    bool canRead(unsigned long num_data_points) {
+        return this->readableElements() >= num_data_points || this->stream_ended.load(std::memory_order_acquire);
+    }
+
+    void nextDataPoints(unsigned long num_data_points);
+
+    template<class IteratorType> IteratorType popDataPoints(IteratorType begin, IteratorType end);
+
+    void addDataPoint(DataPointType data_point);
+
+    template<typename IteratorType> void addDataPoints(IteratorType begin, IteratorType end);
+
+    void notifyStreamEnd();
+
+    void unblockReadOperations() {
+        this->notifyStreamEnd();
+    }
+
+    void discardRestOfStream();
+
+private:
+    void allocateRing(unsigned long max_size);
+
+    unsigned long readableElements();
+
+    unsigned long writableElements();
+
+    template<typename IteratorType> void copyToRing(IteratorType begin, unsigned long count);
+
+    template<typename IteratorType> IteratorType copyFromRing(unsigned long offset, unsigned long count,
+                                                              IteratorType destination);
+
+    void removePointsFromQueue(unsigned long num_data_points);
+
+    template<typename PredicateType> void
+    waitFor(std::atomic<bool> &waiting, std::condition_variable &condition, PredicateType predicate);
+
+    void wakeUp(std::atomic<bool> &waiting, std::condition_variable &condition);
+
+private:
+    enum {
+        cache_line_size = 64,
+        spin_iterations = 64
+    };
+
+    std::unique_ptr<DataPointType[]> ring;
+    unsigned long ring_mask = 0;
+    unsigned long queue_max_size = 4096;
+    std::atomic<bool> stream_ended{false};
+    std::atomic<bool> discarded{false};
+
+    // only written by the reading thread
+    char read_padding[cache_line_size];
+    std::atomic<unsigned long> read_position{0};
+    unsigned long cached_write_position = 0;
+    std::vector<DataPointType> wrapped_window;
+
+    // only written by the writing thread
+    char write_padding[cache_line_size];
+    std::atomic<unsigned long> write_position{0};
+    unsigned long cached_read_position = 0;
+
+    char wait_padding[cache_line_size];
+    std::mutex wait_mutex;
+    std::condition_variable reader_wakeup;
+    std::condition_variable writer_wakeup;
+    std::atomic<bool> reader_waiting{false};
+    std::atomic<bool> writer_waiting{false};
+};
+
+
+template<typename DataPointType> void
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::allocateRing(unsigned long max_size) {
+    unsigned long capacity = 1;
+    while (capacity < max_size) {
+        capacity <<= 1;
+    }
+    this->ring = std::unique_ptr<DataPointType[]>(new DataPointType[capacity]);
+    this->ring_mask = capacity - 1;
+    this->read_position = 0;
+    this->write_position = 0;
+    this->cached_read_position = 0;
+    this->cached_write_position = 0;
+}
+
+template<typename DataPointType> void
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::setQueueMaxSize(unsigned long max_size) {
+    this->queue_max_size = std::max(max_size, 1ul);
+    this->allocateRing(this->queue_max_size);
+}
+
+template<typename DataPointType> unsigned long AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::getQueueMaxSize() {
+    return this->queue_max_size;
+}
+
+template<typename DataPointType> unsigned long AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::getQueueSize() {
+    return this->write_position.load(std::memory_order_acquire) - this->read_position.load(std::memory_order_acquire);
+}
+
+template<typename DataPointType> unsigned long AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::readableElements() {
+    unsigned long read_pos = this->read_position.load(std::memory_order_relaxed);
+    if (this->discarded.load(std::memory_order_acquire)) {
+        this->cached_write_position = this->write_position.load(std::memory_order_acquire);
+        this->read_position.store(this->cached_write_position, std::memory_order_release);
+        return 0;
+    }
+    this->cached_write_position = this->write_position.load(std::memory_order_acquire);
+    return this->cached_write_position - read_pos;
+}
+
+template<typename DataPointType> unsigned long AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::writableElements() {
+    unsigned long write_pos = this->write_position.load(std::memory_order_relaxed);
+    if (write_pos - this->cached_read_position < this->queue_max_size) {
+        return this->queue_max_size - (write_pos - this->cached_read_position);
+    }
+    this->cached_read_position = this->read_position.load(std::memory_order_acquire);
+    return this->queue_max_size - (write_pos - this->cached_read_position);
+}
+
+template<typename DataPointType> template<typename PredicateType> void
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::waitFor(std::atomic<bool> &waiting,
+                                                          std::condition_variable &condition,
+                                                          PredicateType predicate) {
+    for (int i = 0; i < spin_iterations; ++i) {
+        if (predicate()) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> wait_lock(this->wait_mutex);
+    waiting.store(true, std::memory_order_relaxed);
+    // pairs with the fence in wakeUp: either we see the new position or the other side sees that we are waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    condition.wait(wait_lock, predicate);
+    waiting.store(false, std::memory_order_relaxed);
+}
+
+template<typename DataPointType> void
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::wakeUp(std::atomic<bool> &waiting,
+                                                         std::condition_variable &condition) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> wait_lock(this->wait_mutex);
+        condition.notify_one();
+    }
+}
+
+template<typename DataPointType> template<typename IteratorType> void
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::copyToRing(IteratorType begin, unsigned long count) {
+    unsigned long write_pos = this->write_position.load(std::memory_order_relaxed);
+    unsigned long slot = write_pos & this->ring_mask;
+    unsigned long first_part = std::min(count, this->ring_mask + 1 - slot);
+    std::copy_n(begin, first_part, this->ring.get() + slot);
+    std::copy_n(begin + first_part, count - first_part, this->ring.get());
+    this->write_position.store(write_pos + count, std::memory_order_release);
+}
+
+template<typename DataPointType> template<typename IteratorType> IteratorType
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::copyFromRing(unsigned long offset, unsigned long count,
+                                                               IteratorType destination) {
+    unsigned long slot = (this->read_position.load(std::memory_order_relaxed) + offset) & this->ring_mask;
+    unsigned long first_part = std::min(count, this->ring_mask + 1 - slot);
+    destination = std::copy_n(this->ring.get() + slot, first_part, destination);
+    return std::copy_n(this->ring.get(), count - first_part, destination);
+}
+
+template<typename DataPointType> template<typename IteratorType> void
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::addDataPoints(IteratorType begin, IteratorType end) {
+    auto queue_not_full = [this]() -> bool {
+        return this->writableElements() > 0 || this->stream_ended.load(std::memory_order_acquire);
+    };
+
+    while (begin != end && !this->stream_ended.load(std::memory_order_acquire)) {
+        this->waitFor(this->writer_waiting, this->writer_wakeup, queue_not_full);
+        unsigned long elements_pushed = std::min(static_cast<unsigned long>(end - begin), this->writableElements());
+        this->copyToRing(begin, elements_pushed);
+        begin += elements_pushed;
+        this->wakeUp(this->reader_waiting, this->reader_wakeup);
+    }
+}
+
+template<typename DataPointType> void
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::addDataPoint(DataPointType data_point) {
+    this->addDataPoints(&data_point, &data_point + 1);
+}
+
+template<typename DataPointType> template<typename IteratorType> IteratorType
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::getDataPoints(IteratorType begin, IteratorType end,
+                                                                unsigned long offset) {
+    unsigned long num_elements = static_cast<unsigned long>(end - begin) + offset;
+    this->waitFor(this->reader_waiting, this->reader_wakeup, [this, num_elements]() -> bool {
+        return this->readableElements() >= num_elements || this->stream_ended.load(std::memory_order_acquire);
+    });
+    unsigned long readable = this->readableElements();
+    if (readable <= offset) {
+        return begin;
+    }
+    unsigned long elements_pulled = std::min(static_cast<unsigned long>(end - begin), readable - offset);
+    return this->copyFromRing(offset, elements_pulled, begin);
+}
+
+template<typename DataPointType> DataPointWindow<DataPointType>
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::peekDataPoints(unsigned long num_data_points, unsigned long offset) {
+    unsigned long num_elements = num_data_points + offset;
+    this->waitFor(this->reader_waiting, this->reader_wakeup, [this, num_elements]() -> bool {
+        return this->readableElements() >= num_elements || this->stream_ended.load(std::memory_order_acquire);
+    });
+    unsigned long readable = this->readableElements();
+    if (readable <= offset) {
+        return DataPointWindow<DataPointType>();
+    }
+    unsigned long window_size = std::min(num_data_points, readable - offset);
+    unsigned long slot = (this->read_position.load(std::memory_order_relaxed) + offset) & this->ring_mask;
+    if (slot + window_size <= this->ring_mask + 1) {
+        return DataPointWindow<DataPointType>(this->ring.get() + slot, this->ring.get() + slot + window_size);
+    }
+    this->wrapped_window.resize(window_size);
+    this->copyFromRing(offset, window_size, this->wrapped_window.begin());
+    return DataPointWindow<DataPointType>(this->wrapped_window.data(), this->wrapped_window.data() + window_size);
+}
+
+template<typename DataPointType> void
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::nextDataPoints(unsigned long num_data_points) {
+    this->waitFor(this->reader_waiting, this->reader_wakeup, [this, num_data_points]() -> bool {
+        return this->readableElements() >= num_data_points || this->stream_ended.load(std::memory_order_acquire);
+    });
+    this->removePointsFromQueue(num_data_points);
+}
+
+template<typename DataPointType> template<class IteratorType> IteratorType
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::popDataPoints(IteratorType begin, IteratorType end) {
+    auto queue_not_empty = [this]() -> bool {
+        return this->readableElements() > 0 || this->stream_ended.load(std::memory_order_acquire);
+    };
+    do {
+        this->waitFor(this->reader_waiting, this->reader_wakeup, queue_not_empty);
+
+        unsigned long elements_pulled = std::min(static_cast<unsigned long>(end - begin), this->readableElements());
+        begin = this->copyFromRing(0, elements_pulled, begin);
+        this->removePointsFromQueue(elements_pulled);
+    } while (begin != end && !this->stream_ended.load(std::memory_order_acquire));
+    return begin;
+}
+
+template<typename DataPointType> void
+AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::removePointsFromQueue(unsigned long num_data_points) {
+    unsigned long removed = std::min(num_data_points, this->readableElements());
+    this->read_position.store(this->read_position.load(std::memory_order_relaxed) + removed,
+                              std::memory_order_release);
+    this->wakeUp(this->writer_waiting, this->writer_wakeup);
+}
+
+template<typename DataPointType> void AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::notifyStreamEnd() {
+    this->stream_ended.store(true, std::memory_order_release);
+    this->wakeUp(this->reader_waiting, this->reader_wakeup);
+}
+
+template<typename DataPointType> void AsyncDataQueue<DataPointType, SpscRingQueuePolicy>::discardRestOfStream() {
+    this->discarded.store(true, std::memory_order_release);
+    this->stream_ended.store(true, std::memory_order_release);
+    this->wakeUp(this->reader_waiting, this->reader_wakeup);
+    this->wakeUp(this->writer_waiting, this->writer_wakeup);
+}
+
+#endif //SMART_SCREEN_SPSCRINGDATAQUEUE_H
@@ -70,6 +70,7 @@ int clock_gettime(int clk_id, struct timespec* t) {
 
 #define MICROCONTROLLER_CLOCK_FREQUENCY 14745600
 #define PACKET_LENGTH 14
+#define DECODE_BATCH_SIZE 1024
 #define DEVICE_TYPE_MICROCONTROLLER 0x1
 #define DEVICE_TYPE_FPGA 0x2
 
@@ -369,53 +370,58 @@ bool check_trigger_id(uint8_t *buffer) {
     }
     state.last_trigger_id = trigger_id;
 
-    // because we are lazy we also put the packet into the data_queue here
-    uint16_t channels[NUMBER_OF_MEDAL_CHANNELS] = {0}; // medal channels + voltage
-
-    int j = 0;
-    for (; j < NUMBER_OF_MEDAL_CHANNELS; ++j) {
-        int i_counter = 13;
-
-        for (; i_counter >= 2; --i_counter) {
+    return true;
+}
 
-            channels[j] <<= 1;
+/* Decodes and calibrates complete packets in batches and puts them into the data_queue
+ *
+ * \param  packets the first packet
+ * \param  number_of_packets the number of complete packets
+ * \param  first_packet_time the CLOCK_MONOTONIC time of the first packet in nanoseconds
+ */
+static void add_packets(const uint8_t *packets, size_t number_of_packets, uint64_t first_packet_time) {
+    static float samples[DECODE_BATCH_SIZE * NUMBER_OF_MEDAL_CHANNELS];
 
-            int or_value = (buffer[i_counter] & (1 << (j + 1))) >= 1 ;
-            channels[j] |= or_value;
+    while (number_of_packets > 0) {
+        size_t batch_size = number_of_packets < DECODE_BATCH_SIZE ? number_of_packets : DECODE_BATCH_SIZE;
+        decodeMEDALPackets(packets, batch_size, samples);
 
+        struct timespec batch_time;
+        batch_time.tv_sec = first_packet_time / 1000000000ULL;
+        batch_time.tv_nsec = first_packet_time % 1000000000ULL;
+        addMEDALDataPoints(samples, batch_size, &batch_time);
 
-        }
+        packets += batch_size * PACKET_LENGTH;
+        number_of_packets -= batch_size;
+        first_packet_time += (uint64_t) batch_size * 1000000000ULL / config.frequency;
     }
-
-
-    float calibrated_channels[NUMBER_OF_MEDAL_CHANNELS];
-    calibrated_channels[0] = (((float) channels[0]) -2500) * 0.015151515f; //  1 / 0.066 V/A * (4.096 / 4096)
-    calibrated_channels[1] = (((float) channels[1]) -2500) * 0.005405405f; //  1 / 0.185 V/A * (4.096 / 4096)
-    calibrated_channels[2] = (((float) channels[2]) -2500) *0.005405405f; //  1 / 0.185 V/A * (4.096 / 4096)
-    calibrated_channels[3] = (((float) channels[3]) -2500) *0.005405405f; //  1 / 0.185 V/A * (4.096 / 4096)
-    calibrated_channels[4] = (((float) channels[4]) -2500) *0.005405405f; //  1 / 0.185 V/A * (4.096 / 4096)
-    calibrated_channels[5] = (((float) channels[5]) -2500) * 0.005405405f; //  1 / 0.185 V/A * (4.096 / 4096)
-    calibrated_channels[6] = (((float) channels[6]) -2380) *
-                             0.2853f; // 230V / (6V * 1.478 estimated IdleVolt) * (100000Ohm + 10000Ohm) / 10000Ohm) * (4.096 / 4096)
-    addMEDALDataPoint(calibrated_channels[0], calibrated_channels[1], calibrated_channels[2], calibrated_channels[3],
-                      calibrated_channels[4], calibrated_channels[5], calibrated_channels[6]);
-
-    return true;
 }
 
 /* Verifies that all trigger ids of the current buffer (and previous incomplete packets)
  * are strictly increasing (including overflow)
  */
 bool verify_trigger_ids(uint8_t *buffer, size_t length) {
+    // the last complete packet of the buffer was sampled just now, the packets before it one sample period apart each
+    struct timespec received_time;
+    clock_gettime(CLOCK_MONOTONIC, &received_time);
+    uint64_t last_packet_time = (uint64_t) received_time.tv_sec * 1000000000ULL + received_time.tv_nsec;
+    size_t offset = (state.last_incomplete_packet_length ? PACKET_LENGTH - state.last_incomplete_packet_length : 0);
+    size_t complete_packets = (state.last_incomplete_packet_length > 0) + (length - offset) / PACKET_LENGTH;
+    uint64_t packet_time = last_packet_time;
+    if (complete_packets > 0) {
+        packet_time -= (uint64_t) (complete_packets - 1) * 1000000000ULL / config.frequency;
+    }
+
     if (state.last_incomplete_packet_length > 0) {
         memcpy(state.last_incomplete_packet + state.last_incomplete_packet_length, buffer,
                PACKET_LENGTH - state.last_incomplete_packet_length);
         if (!check_trigger_id(state.last_incomplete_packet)) {
             return false;
         }
+        add_packets(state.last_incomplete_packet, 1, packet_time);
+        packet_time += 1000000000ULL / config.frequency;
     }
 
-    size_t offset = (state.last_incomplete_packet_length ? PACKET_LENGTH - state.last_incomplete_packet_length : 0);
     size_t length_to_check = length - offset;
     state.last_incomplete_packet_length = length_to_check % PACKET_LENGTH;
     length_to_check -= state.last_incomplete_packet_length;
@@ -426,6 +432,7 @@ bool verify_trigger_ids(uint8_t *buffer, size_t length) {
             return false;
         }
     }
+    add_packets(buffer + offset, length_to_check / PACKET_LENGTH, packet_time);
 
     memset(state.last_incomplete_packet, 0, PACKET_LENGTH);
     memcpy(state.last_incomplete_packet, buffer + offset + length_to_check, state.last_incomplete_packet_length);
@@ -2,6 +2,7 @@
 #define SMART_SCREEN_MEDALDATAPOINT_H
 
 #include <exception>
+#include <numeric>
 
 #define NUMBER_OF_MEDAL_CHANNELS 6
 
@@ -9,6 +10,10 @@ struct MEDALDataPoint {
 
     typedef float datum;
 
+    enum {
+        number_of_channels = NUMBER_OF_MEDAL_CHANNELS
+    };
+
     datum volts;
     datum currents[NUMBER_OF_MEDAL_CHANNELS];
 
@@ -18,6 +23,11 @@ struct MEDALDataPoint {
 
     datum ampere() const { return std::accumulate(currents, currents+NUMBER_OF_MEDAL_CHANNELS, 0.f); }
 
+    /**
+     * @brief The currents of the single channels, used by the MultiChannelEventDetectionStrategy instead of the sum.
+     */
+    const datum *channels() const { return currents; }
+
     void ampere(datum a) {
         throw std::exception(); // not to be used, u dimwit
     }
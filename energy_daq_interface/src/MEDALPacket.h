@@ -0,0 +1,184 @@
+#ifndef SMART_SCREEN_MEDALPACKET_H
+#define SMART_SCREEN_MEDALPACKET_H
+
+#include <cstdint>
+#include <cstddef>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Layout and decoding of the 14 byte packets the MEDAL microcontroller sends and energy_daq stores in its .bin files.
+ *
+ * Bytes 0 and 1 hold the big endian trigger id. Bytes 2 to 13 hold one bit of every channel each, byte 2 the least
+ * significant one. Bit 0 is unused, bits 1 to 6 are the six current channels and bit 7 is the voltage channel.
+ */
+class MEDALPacket {
+public:
+    enum {
+        packet_length = 14,
+        number_of_channels = 7,
+        number_of_currents = 6,
+        voltage_channel = 6,
+        bits_per_sample = 12,
+        current_offset = 2500, /**< Raw value of a current channel at 0 A */
+        voltage_offset = 2380 /**< Estimated raw value of the voltage channel at 0 V, used when the mean is not known */
+    };
+
+    /**
+     * @brief Ampere per raw value of the 30 A channel: 1 / 0.066 V/A * (4.096 / 4096)
+     */
+    static constexpr double calibration_30a = 0.015151515;
+    /**
+     * @brief Ampere per raw value of the 5 A channels: 1 / 0.185 V/A * (4.096 / 4096)
+     */
+    static constexpr double calibration_5a = 0.005405405;
+    /**
+     * @brief Volt per raw value: 230V / (6V * 1.478 estimated IdleVolt) * (100000Ohm + 10000Ohm) / 10000Ohm) * (4.096 / 4096)
+     */
+    static constexpr double calibration_voltage = 0.2853;
+
+    static uint16_t triggerId(const uint8_t *packet) {
+        return static_cast<uint16_t>(packet[0] << 8 | packet[1]);
+    }
+
+    /**
+     * @brief Returns true if trigger_id directly follows previous_trigger_id, including the overflow from 65535 to 0.
+     */
+    static bool isNextTriggerId(uint16_t previous_trigger_id, uint16_t trigger_id) {
+        return static_cast<uint16_t>(previous_trigger_id + 1) == trigger_id;
+    }
+
+    /**
+     * @brief Extracts the raw 12 bit values of all channels, the six currents followed by the voltage.
+     */
+    static void decodeChannels(const uint8_t *packet, uint16_t *channels);
+
+    /**
+     * @brief Extracts the raw values of number_of_packets consecutive packets. channels[c] receives the values of channel c.
+     *
+     * With SSE2 the bits of one channel are gathered from all twelve bytes with a single movemask, otherwise the bytes are
+     * looked up in a table that spreads their bits over the channels.
+     */
+    static void decodePackets(const uint8_t *packets, std::size_t number_of_packets, uint16_t *const *channels);
+
+    /**
+     * @brief Decodes and calibrates number_of_packets packets into samples, seven floats per packet in the order of
+     * addMEDALDataPoint: the six currents in A followed by the voltage in V.
+     */
+    static void decodeCalibratedPackets(const uint8_t *packets, std::size_t number_of_packets, float *samples);
+
+    static double calibrationFactor(unsigned int channel) {
+        if (channel == voltage_channel) {
+            return calibration_voltage;
+        }
+        return channel == 0 ? calibration_30a : calibration_5a;
+    }
+
+    static uint16_t channelOffset(unsigned int channel) {
+        return channel == voltage_channel ? voltage_offset : current_offset;
+    }
+
+private:
+    enum {
+        calibration_block_size = 256,
+        lanes_per_table = 4
+    };
+
+    static void decodePacketWithTable(const uint8_t *packet, uint16_t *const *channels, std::size_t index);
+
+#ifdef __SSE2__
+    template<int Channel> static uint16_t gatherChannel(__m128i packet) {
+        // move the bit of the channel to the top of every byte, bytes 2 to 13 then end up in bits 2 to 13 of the mask
+        int mask = _mm_movemask_epi8(_mm_slli_epi16(packet, 6 - Channel));
+        return static_cast<uint16_t>((mask >> 2) & 0xfff);
+    }
+#endif
+};
+
+inline void MEDALPacket::decodeChannels(const uint8_t *packet, uint16_t *channels) {
+    for (unsigned int channel = 0; channel < number_of_channels; ++channel) {
+        uint16_t value = 0;
+        for (unsigned int bit = 0; bit < bits_per_sample; ++bit) {
+            value |= static_cast<uint16_t>(((packet[2 + bit] >> (channel + 1)) & 1) << bit);
+        }
+        channels[channel] = value;
+    }
+}
+
+inline void MEDALPacket::decodePacketWithTable(const uint8_t *packet, uint16_t *const *channels, std::size_t index) {
+    // spread_table[t][byte] holds the bits 1 to 7 of byte in the lowest bit of 16 bit lanes, four channels per table
+    struct SpreadTable {
+        uint64_t entries[2][256];
+
+        SpreadTable() {
+            for (unsigned int byte = 0; byte < 256; ++byte) {
+                entries[0][byte] = 0;
+                entries[1][byte] = 0;
+                for (unsigned int channel = 0; channel < number_of_channels; ++channel) {
+                    uint64_t bit = (byte >> (channel + 1)) & 1;
+                    entries[channel / lanes_per_table][byte] |= bit << (16 * (channel % lanes_per_table));
+                }
+            }
+        }
+    };
+    static const SpreadTable spread_table;
+
+    uint64_t lanes[2] = {0, 0};
+    for (unsigned int bit = 0; bit < bits_per_sample; ++bit) {
+        lanes[0] |= spread_table.entries[0][packet[2 + bit]] << bit;
+        lanes[1] |= spread_table.entries[1][packet[2 + bit]] << bit;
+    }
+    for (unsigned int channel = 0; channel < number_of_channels; ++channel) {
+        channels[channel][index] = static_cast<uint16_t>(lanes[channel / lanes_per_table] >> (16 * (channel % lanes_per_table)));
+    }
+}
+
+inline void
+MEDALPacket::decodePackets(const uint8_t *packets, std::size_t number_of_packets, uint16_t *const *channels) {
+    std::size_t i = 0;
+#ifdef __SSE2__
+    // a 16 byte load reaches two bytes into the next packet, so the last packet is decoded with the table
+    for (; i + 1 < number_of_packets; ++i) {
+        __m128i packet = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packets + i * packet_length));
+        channels[0][i] = gatherChannel<0>(packet);
+        channels[1][i] = gatherChannel<1>(packet);
+        channels[2][i] = gatherChannel<2>(packet);
+        channels[3][i] = gatherChannel<3>(packet);
+        channels[4][i] = gatherChannel<4>(packet);
+        channels[5][i] = gatherChannel<5>(packet);
+        channels[6][i] = gatherChannel<6>(packet);
+    }
+#endif
+    for (; i < number_of_packets; ++i) {
+        decodePacketWithTable(packets + i * packet_length, channels, i);
+    }
+}
+
+inline void MEDALPacket::decodeCalibratedPackets(const uint8_t *packets, std::size_t number_of_packets, float *samples) {
+    uint16_t raw_values[number_of_channels][calibration_block_size];
+    uint16_t *channels[number_of_channels];
+    for (unsigned int channel = 0; channel < number_of_channels; ++channel) {
+        channels[channel] = raw_values[channel];
+    }
+
+    for (std::size_t first = 0; first < number_of_packets; first += calibration_block_size) {
+        std::size_t block_size = number_of_packets - first;
+        if (block_size > calibration_block_size) {
+            block_size = calibration_block_size;
+        }
+        decodePackets(packets + first * packet_length, block_size, channels);
+        float *block_samples = samples + first * number_of_channels;
+        for (unsigned int channel = 0; channel < number_of_channels; ++channel) {
+            const float offset = channelOffset(channel);
+            const float factor = static_cast<float>(calibrationFactor(channel));
+            const uint16_t *raw = raw_values[channel];
+            for (std::size_t i = 0; i < block_size; ++i) {
+                block_samples[i * number_of_channels + channel] = (static_cast<float>(raw[i]) - offset) * factor;
+            }
+        }
+    }
+}
+
+#endif //SMART_SCREEN_MEDALPACKET_H
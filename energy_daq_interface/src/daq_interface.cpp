@@ -3,24 +3,89 @@
 #include <AsyncDataQueue.h>
 #include <DataClassifier.h>
 #include <EventDetector.h>
+#include <MultiChannelEventDetectionStrategy.h>
 #include "MEDALDataPoint.h"
+#include "MEDALPacket.h"
 #include "daq_interface.h"
 #include <iostream>
 #include <iomanip>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/iterator/transform_iterator.hpp>
 
 AsyncDataQueue<MEDALDataPoint> data_queue;
 DynamicStreamMetaData stream_meta_data;
-EventDetector<DefaultEventDetectionStrategy,MEDALDataPoint> event_detector;
+// every current channel of the board is one circuit, so the events are detected per channel
+typedef MultiChannelEventDetectionStrategy<MEDALDataPoint::number_of_channels> MEDALEventDetectionStrategy;
+EventDetector<MEDALEventDetectionStrategy,MEDALDataPoint> event_detector;
 DataClassifier<MEDALDataPoint> event_analyzer;
 #define MEDAL_BUFFER_SIZE 5000
 int buffer_pos = 0;
 MEDALDataPoint buffer[MEDAL_BUFFER_SIZE];
 DynamicStreamMetaData::DataPointIdType data_point_id = 0;
+unsigned int stream_sample_rate = 1;
+// pair of monotonic and local time taken at initialization, to convert the timestamps of addMEDALDataPoints
+timespec monotonic_reference_time;
+DynamicStreamMetaData::TimeType local_reference_time;
+MEDALEventCallback event_callback = nullptr;
+void *event_callback_user_data = nullptr;
 
+/**
+ * @brief Converts the sample with the given index of an addMEDALDataPoints call to a MEDALDataPoint.
+ */
+struct SampleToMEDALDataPoint {
+    explicit SampleToMEDALDataPoint(const float *packet_samples) : samples(packet_samples) {}
+
+    MEDALDataPoint operator()(std::size_t index) const {
+        const float *sample = this->samples + index * MEDALPacket::number_of_channels;
+        MEDALDataPoint dp;
+        std::copy(sample, sample + NUMBER_OF_MEDAL_CHANNELS, dp.currents);
+        dp.volts = sample[MEDALPacket::voltage_channel];
+        return dp;
+    }
+
+    const float *samples;
+};
+
+static DynamicStreamMetaData::TimeType monotonicToLocalTime(const timespec &monotonic_time) {
+    int64_t microseconds = (static_cast<int64_t>(monotonic_time.tv_sec) - monotonic_reference_time.tv_sec) * 1000000 +
+                           (static_cast<int64_t>(monotonic_time.tv_nsec) - monotonic_reference_time.tv_nsec) / 1000;
+    return local_reference_time + DynamicStreamMetaData::USDurationType(microseconds);
+}
+
+static timespec localToMonotonicTime(const DynamicStreamMetaData::TimeType &local_time) {
+    int64_t nanoseconds = monotonic_reference_time.tv_nsec +
+                          (local_time - local_reference_time).total_microseconds() * 1000;
+    timespec monotonic_time;
+    monotonic_time.tv_sec = monotonic_reference_time.tv_sec + nanoseconds / 1000000000;
+    monotonic_time.tv_nsec = nanoseconds % 1000000000;
+    if (monotonic_time.tv_nsec < 0) {
+        monotonic_time.tv_nsec += 1000000000;
+        --monotonic_time.tv_sec;
+    }
+    return monotonic_time;
+}
+
+static void flushBuffer() {
+    if (buffer_pos == 0) {
+        return;
+    }
+    stream_meta_data.syncTimePoint(data_point_id, boost::posix_time::microsec_clock::local_time());
+    data_queue.addDataPoints(buffer, buffer + buffer_pos);
+    buffer_pos = 0;
+}
 
 
+
+extern "C" void setMEDALEventCallback(MEDALEventCallback callback, void *user_data) {
+    event_callback = callback;
+    event_callback_user_data = user_data;
+}
+
 extern "C" void init_daq_interface(unsigned int sample_rate) {
     data_queue.setQueueMaxSize(sample_rate*3);
+    stream_sample_rate = std::max(sample_rate, 1u);
+    clock_gettime(CLOCK_MONOTONIC, &monotonic_reference_time);
+    local_reference_time = boost::posix_time::microsec_clock::local_time();
     PowerMetaData meta_data;
     meta_data.sample_rate = sample_rate;
     meta_data.frequency = 50;
@@ -32,9 +97,16 @@ extern "C" void init_daq_interface(unsigned int sample_rate) {
     stream_meta_data.setFixedPowerMetaData(meta_data);
     stream_meta_data.syncTimePoint(0,boost::posix_time::second_clock::local_time());
     event_detector.storage.setEventStorageCallback([](Event<MEDALDataPoint>& event) {
+        if (event_callback != nullptr) {
+            timespec event_time = localToMonotonicTime(event.event_meta_data.event_time);
+            // the event time is the first sample of the data_points_stored_of_event
+            int samples_from_event_time = event.event_meta_data.power_meta_data.data_points_stored_of_event;
+            event_callback(&event_time, static_cast<size_t>(std::max(samples_from_event_time, 0)),
+                           event_callback_user_data);
+        }
         event_analyzer.pushEvent(event);
     });
-    event_detector.startAnalyzing(&data_queue,&stream_meta_data,DefaultEventDetectionStrategy(0.3));
+    event_detector.startAnalyzing(&data_queue,&stream_meta_data,MEDALEventDetectionStrategy(0.3));
 
     event_analyzer.startClassification();
 
@@ -55,13 +127,39 @@ extern "C" void  addMEDALDataPoint(float current0, float current1, float current
     ++buffer_pos;
     ++data_point_id;
     if(buffer_pos == MEDAL_BUFFER_SIZE) {
-        stream_meta_data.syncTimePoint(data_point_id, boost::posix_time::second_clock::local_time());
-        data_queue.addDataPoints(buffer, buffer+MEDAL_BUFFER_SIZE);
-        buffer_pos = 0;
+        flushBuffer();
+    }
+}
+
+extern "C" void addMEDALDataPoints(const float *samples, size_t number_of_samples, const timespec *first_sample_time) {
+    // samples of addMEDALDataPoint that are still buffered come first
+    flushBuffer();
+    if (number_of_samples == 0) {
+        return;
     }
+
+    DynamicStreamMetaData::TimeType time;
+    if (first_sample_time != nullptr) {
+        time = monotonicToLocalTime(*first_sample_time);
+    } else {
+        int64_t duration = static_cast<int64_t>(number_of_samples - 1) * 1000000 / stream_sample_rate;
+        time = boost::posix_time::microsec_clock::local_time() - DynamicStreamMetaData::USDurationType(duration);
+    }
+    stream_meta_data.syncTimePoint(data_point_id, time);
+
+    // the samples are converted while they are copied into the queue
+    auto first_data_point = boost::make_transform_iterator(boost::counting_iterator<std::size_t>(0),
+                                                           SampleToMEDALDataPoint(samples));
+    data_queue.addDataPoints(first_data_point, first_data_point + number_of_samples);
+    data_point_id += number_of_samples;
+}
+
+extern "C" void decodeMEDALPackets(const unsigned char *packets, size_t number_of_packets, float *samples) {
+    MEDALPacket::decodeCalibratedPackets(packets, number_of_packets, samples);
 }
 
 extern "C" void  free_daq_interface() {
+    flushBuffer();
     data_queue.notifyStreamEnd();
     event_detector.join();
 
@@ -3,14 +3,39 @@
 
 #ifdef __cplusplus
 #define DAQ_INTERFACE_EXTERN_C extern "C"
+#include <cstddef>
 #else
 #define DAQ_INTERFACE_EXTERN_C
-
+#include <stddef.h>
 #endif
+#include <time.h>
+
+typedef void (*MEDALEventCallback)(const struct timespec *event_time, size_t samples_from_event_time, void *user_data);
+
+/**
+ * Registers a function that is called on the event detector thread for every detected event, with the
+ * CLOCK_MONOTONIC time of the event and the number of samples the event holds from that time on. The last of them
+ * is the sample that completed the event. Has to be called before init_daq_interface.
+ */
+DAQ_INTERFACE_EXTERN_C void setMEDALEventCallback(MEDALEventCallback callback, void *user_data);
 
 DAQ_INTERFACE_EXTERN_C void init_daq_interface(unsigned int sample_rate);
 DAQ_INTERFACE_EXTERN_C void addMEDALDataPoint(float current0,float current1,float current2,float current3,float current4,float current5,float voltage);
 
+/**
+ * Adds number_of_samples samples at once, seven floats per sample in the argument order of addMEDALDataPoint.
+ * If first_sample_time is not NULL it is the CLOCK_MONOTONIC time the first sample was taken at, otherwise the
+ * samples are assumed to end now.
+ */
+DAQ_INTERFACE_EXTERN_C void addMEDALDataPoints(const float *samples, size_t number_of_samples,
+                                               const struct timespec *first_sample_time);
+
+/**
+ * Decodes number_of_packets raw 14 byte MEDAL packets into calibrated samples, seven floats per packet in the
+ * argument order of addMEDALDataPoint.
+ */
+DAQ_INTERFACE_EXTERN_C void decodeMEDALPackets(const unsigned char *packets, size_t number_of_packets, float *samples);
+
 
 DAQ_INTERFACE_EXTERN_C void free_daq_interface();
 #endif //SMART_SCREEN_DAQ_INTERFACE_H_H
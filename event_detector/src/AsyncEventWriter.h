@@ -0,0 +1,202 @@
+#ifndef SMART_SCREEN_ASYNCEVENTWRITER_H
+#define SMART_SCREEN_ASYNCEVENTWRITER_H
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <utility>
+#include <algorithm>
+#include <iostream>
+
+#include "Event.h"
+
+namespace PersistenceOverflowPolicy {
+    enum PersistenceOverflowPolicy {
+        Block, /**< The detector waits until the writer has room for the event. No event is lost. */
+        DropCSV, /**< The CSV dumps of the pending events are skipped until the writer has caught up. The detector only waits if twice the maximum number of events is pending. */
+        Spill /**< Events that do not fit into the queue are appended to a binary spill archive by the detector itself. */
+    };
+}
+
+/**
+ * @brief Persists events on a dedicated thread so that the detection thread does not wait for the disk.
+ *
+ * push hands the event over to a bounded queue which the writer thread empties by calling the persist function. What happens when
+ * the queue is full is decided by the PersistenceOverflowPolicy. Exceptions thrown while persisting are rethrown by the next call
+ * of push or waitUntilEmpty. The destructor waits until all pending events are persisted, it can not throw and only reports an
+ * exception that was not rethrown yet on std::cerr. Call waitUntilEmpty before to handle it.
+ */
+template<typename DataPointType> class AsyncEventWriter {
+public:
+    typedef std::function<void(const Event<DataPointType> &, bool store_csv)> PersistFunctionType;
+    typedef std::function<void(const Event<DataPointType> &)> SpillFunctionType;
+
+    AsyncEventWriter(PersistFunctionType persist_function, SpillFunctionType spill_function,
+                     unsigned long max_pending_events = 64,
+                     PersistenceOverflowPolicy::PersistenceOverflowPolicy policy = PersistenceOverflowPolicy::Block);
+
+    ~AsyncEventWriter();
+
+    AsyncEventWriter(const AsyncEventWriter &) = delete;
+
+    AsyncEventWriter &operator=(const AsyncEventWriter &) = delete;
+
+    void push(Event<DataPointType> &&event);
+
+    /**
+     * @brief Blocks until every event that was pushed is persisted.
+     */
+    void waitUntilEmpty();
+
+    unsigned long spilledEvents() {
+        std::lock_guard<std::mutex> lock(this->queue_mutex);
+        return this->spilled_events;
+    }
+
+    unsigned long droppedCSVs() {
+        std::lock_guard<std::mutex> lock(this->queue_mutex);
+        return this->dropped_csvs;
+    }
+
+private:
+    struct PendingEvent {
+        Event<DataPointType> event;
+        bool store_csv;
+    };
+
+    void run();
+
+    void rethrowWriterException();
+
+private:
+    PersistFunctionType persist;
+    SpillFunctionType spill;
+    unsigned long max_pending;
+    PersistenceOverflowPolicy::PersistenceOverflowPolicy overflow_policy;
+
+    std::mutex queue_mutex;
+    std::condition_variable events_available;
+    std::condition_variable space_available;
+    std::condition_variable events_persisted;
+    std::deque<PendingEvent> pending_events;
+    bool event_in_progress = false;
+    bool stop = false;
+    std::exception_ptr writer_exception;
+
+    unsigned long spilled_events = 0;
+    unsigned long dropped_csvs = 0;
+
+    std::thread writer;
+};
+
+template<typename DataPointType>
+AsyncEventWriter<DataPointType>::AsyncEventWriter(PersistFunctionType persist_function, SpillFunctionType spill_function,
+                                                  unsigned long max_pending_events,
+                                                  PersistenceOverflowPolicy::PersistenceOverflowPolicy policy) :
+        persist(std::move(persist_function)), spill(std::move(spill_function)),
+        max_pending(std::max(max_pending_events, 1ul)), overflow_policy(policy) {
+    this->writer = std::thread(&AsyncEventWriter<DataPointType>::run, this);
+}
+
+template<typename DataPointType> AsyncEventWriter<DataPointType>::~AsyncEventWriter() {
+    {
+        std::lock_guard<std::mutex> lock(this->queue_mutex);
+        this->stop = true;
+    }
+    this->events_available.notify_one();
+    this->writer.join();
+    if (this->writer_exception) {
+        try {
+            std::rethrow_exception(this->writer_exception);
+        } catch (const std::exception &e) {
+            std::cerr << "Pending events could not be persisted: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Pending events could not be persisted" << std::endl;
+        }
+    }
+}
+
+template<typename DataPointType> void AsyncEventWriter<DataPointType>::push(Event<DataPointType> &&event) {
+    std::unique_lock<std::mutex> lock(this->queue_mutex);
+    this->rethrowWriterException();
+
+    bool store_csv = true;
+    if (this->pending_events.size() >= this->max_pending) {
+        if (this->overflow_policy == PersistenceOverflowPolicy::Spill) {
+            ++this->spilled_events;
+            lock.unlock();
+            this->spill(event);
+            return;
+        }
+        if (this->overflow_policy == PersistenceOverflowPolicy::DropCSV) {
+            // writing only the archives lets the writer catch up faster
+            for (auto &pending: this->pending_events) {
+                this->dropped_csvs += pending.store_csv ? 1 : 0;
+                pending.store_csv = false;
+            }
+            ++this->dropped_csvs;
+            store_csv = false;
+        }
+        const unsigned long max_queue_size = this->overflow_policy == PersistenceOverflowPolicy::DropCSV ?
+                                             2 * this->max_pending : this->max_pending;
+        this->space_available.wait(lock, [this, max_queue_size]() {
+            return this->pending_events.size() < max_queue_size || this->writer_exception;
+        });
+        this->rethrowWriterException();
+    }
+    this->pending_events.push_back(PendingEvent{std::move(event), store_csv});
+    lock.unlock();
+    this->events_available.notify_one();
+}
+
+template<typename DataPointType> void AsyncEventWriter<DataPointType>::waitUntilEmpty() {
+    std::unique_lock<std::mutex> lock(this->queue_mutex);
+    this->events_persisted.wait(lock, [this]() {
+        return (this->pending_events.empty() && !this->event_in_progress) || this->writer_exception;
+    });
+    this->rethrowWriterException();
+}
+
+template<typename DataPointType> void AsyncEventWriter<DataPointType>::rethrowWriterException() {
+    if (this->writer_exception) {
+        std::exception_ptr exception = this->writer_exception;
+        this->writer_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+template<typename DataPointType> void AsyncEventWriter<DataPointType>::run() {
+    std::unique_lock<std::mutex> lock(this->queue_mutex);
+    while (true) {
+        this->events_available.wait(lock, [this]() {
+            return this->stop || !this->pending_events.empty();
+        });
+        if (this->pending_events.empty()) {
+            // stop is only honoured once all events are persisted
+            return;
+        }
+        PendingEvent pending = std::move(this->pending_events.front());
+        this->pending_events.pop_front();
+        this->event_in_progress = true;
+        lock.unlock();
+        this->space_available.notify_one();
+
+        try {
+            this->persist(pending.event, pending.store_csv);
+        } catch (...) {
+            lock.lock();
+            this->writer_exception = std::current_exception();
+            lock.unlock();
+        }
+
+        lock.lock();
+        this->event_in_progress = false;
+        this->events_persisted.notify_all();
+        this->space_available.notify_one();
+    }
+}
+
+#endif //SMART_SCREEN_ASYNCEVENTWRITER_H
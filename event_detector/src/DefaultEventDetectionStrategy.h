@@ -13,6 +13,7 @@ public:
 
     template<typename IteratorType> bool
     detectEvent(IteratorType begin, IteratorType end, unsigned int num_data_points_per_period) {
+        period_length = num_data_points_per_period;
         if (none_detected_yet) {
             previous_rms = Algorithms::rootMeanSquareOfAmpere(begin, end);
             none_detected_yet = false;
@@ -32,7 +33,22 @@ public:
         }
     }
 
+    /**
+     * @brief Returns the position of the sample within the last tested period at which the event was detected. This strategy only evaluates whole periods, so this is always the end of the period.
+     */
+    unsigned long detectedEventPosition() const {
+        return period_length;
+    }
+
+    /**
+     * @brief Events are detected on the sum of all channels, so no channel is reported.
+     */
+    unsigned long detectedChannels() const {
+        return 0;
+    }
+
 private:
+    unsigned long period_length = 0;
     bool none_detected_yet = true;
     float previous_rms = none_detected_yet;
     float threshold;
@@ -0,0 +1,304 @@
+#ifndef SMART_SCREEN_DETECTIONSERVER_H
+#define SMART_SCREEN_DETECTIONSERVER_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
+
+#include "EventDetector.h"
+
+/**
+ * @brief Detects the events of many independent streams, for example all meters connected to one host, with a fixed number
+ * of worker threads.
+ *
+ * Starting an EventDetector per stream costs one thread per meter, which does not scale to hundreds of meters. The server
+ * drives the detectors of all streams with analyzeAvailableDataPoints instead. A stream that has enough data points in its
+ * queue is put into the queue of its home worker, a worker that runs out of streams steals the oldest stream of another
+ * worker. Each scheduled stream analyzes at most periods_per_slice periods before it is put back, so a busy meter can not
+ * starve the others. A stream is scheduled at most once at a time, so its detector is never used by two workers at once.
+ *
+ * The events of all streams are handed to one callback, which is called by the workers and therefore has to be thread safe,
+ * for example DataClassifier::pushEvent.
+ */
+template<typename EventDetectionStrategyType = DefaultEventDetectionStrategy, typename DataPointType = DefaultDataPoint>
+class DetectionServer {
+public:
+    typedef unsigned long StreamIdType;
+    typedef std::function<void(StreamIdType, Event<DataPointType> &)> EventCallbackType;
+
+    /**
+     * @brief Starts the workers. Uses one worker per hardware thread if number_of_workers is 0.
+     */
+    explicit DetectionServer(unsigned int number_of_workers = 0);
+
+    ~DetectionServer();
+
+    DetectionServer(const DetectionServer &) = delete;
+
+    DetectionServer &operator=(const DetectionServer &) = delete;
+
+    /**
+     * @brief Adds a stream with its own queue and detector. The events of the stream are stored in a subdirectory of
+     * event_directory named after the stream id.
+     * @return Returns the id of the new stream.
+     */
+    StreamIdType addStream(const PowerMetaData &meta_data,
+                           EventDetectionStrategyType strategy = EventDetectionStrategyType());
+
+    /**
+     * @brief Appends data points to the queue of the stream and schedules it. Only one thread may add data points to a stream.
+     * Blocks while the queue of the stream is full.
+     */
+    template<typename IteratorType> void addDataPoints(StreamIdType stream_id, IteratorType begin, IteratorType end);
+
+    /**
+     * @brief Marks the end of the stream, the data points still in its queue are analyzed.
+     */
+    void endStream(StreamIdType stream_id);
+
+    /**
+     * @brief Blocks until every stream has ended and all of their data points are analyzed.
+     */
+    void waitUntilDone();
+
+    /**
+     * @brief Sets the callback that is called for every stored event. Has to be set before the first stream is added.
+     */
+    void setEventCallback(EventCallbackType callback);
+
+    DynamicStreamMetaData &streamMetaData(StreamIdType stream_id);
+
+    EventStorage<DataPointType> &streamStorage(StreamIdType stream_id);
+
+public:
+    // number of periods a stream analyzes before the worker moves on to the next stream
+    unsigned long periods_per_slice = 50;
+    std::string event_directory = "events";
+
+private:
+    struct Stream {
+        StreamIdType id;
+        AsyncDataQueue<DataPointType> queue;
+        DynamicStreamMetaData meta_data;
+        EventDetector<EventDetectionStrategyType, DataPointType> detector;
+        // true while the stream waits in a worker queue or is analyzed by a worker
+        std::atomic<bool> scheduled{false};
+    };
+
+    Stream &stream(StreamIdType stream_id);
+
+    void schedule(Stream *to_schedule);
+
+    void work(unsigned int worker);
+
+    Stream *takeStream(unsigned int worker);
+
+    void runSlice(Stream *to_run);
+
+private:
+    std::mutex server_mutex;
+    std::condition_variable work_available;
+    std::condition_variable streams_done;
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::vector<std::deque<Stream *>> worker_queues;
+    unsigned long finished_streams = 0;
+    bool stop_workers = false;
+    EventCallbackType event_callback = [](StreamIdType, Event<DataPointType> &) {};
+
+    // started last, the workers use all other members
+    std::vector<std::thread> workers;
+};
+
+template<typename EventDetectionStrategyType, typename DataPointType>
+DetectionServer<EventDetectionStrategyType, DataPointType>::DetectionServer(unsigned int number_of_workers) {
+    if (number_of_workers == 0) {
+        number_of_workers = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    this->worker_queues.resize(number_of_workers);
+    for (unsigned int worker = 0; worker < number_of_workers; ++worker) {
+        this->workers.emplace_back(&DetectionServer<EventDetectionStrategyType, DataPointType>::work, this, worker);
+    }
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType>
+DetectionServer<EventDetectionStrategyType, DataPointType>::~DetectionServer() {
+    {
+        std::lock_guard<std::mutex> server_lock(this->server_mutex);
+        this->stop_workers = true;
+    }
+    this->work_available.notify_all();
+    for (auto &worker: this->workers) {
+        worker.join();
+    }
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType>
+typename DetectionServer<EventDetectionStrategyType, DataPointType>::StreamIdType
+DetectionServer<EventDetectionStrategyType, DataPointType>::addStream(const PowerMetaData &meta_data,
+                                                                      EventDetectionStrategyType strategy) {
+    std::unique_ptr<Stream> new_stream(new Stream());
+    new_stream->meta_data.setFixedPowerMetaData(meta_data);
+
+    // the queue has to hold an event and the period in front of it, otherwise the detector could never continue
+    long event_size = std::max(meta_data.data_points_stored_before_event + meta_data.data_points_stored_of_event, 0);
+    unsigned long minimum_queue_size = 2 * (static_cast<unsigned long>(event_size) + meta_data.dataPointsPerPeriod());
+    new_stream->queue.setQueueMaxSize(std::max<unsigned long>(meta_data.max_data_points_in_queue, minimum_queue_size));
+
+    std::lock_guard<std::mutex> server_lock(this->server_mutex);
+    const StreamIdType stream_id = this->streams.size();
+    new_stream->id = stream_id;
+
+    const std::string stream_directory = this->event_directory + "/" + std::to_string(stream_id);
+    ::mkdir(this->event_directory.c_str(), 0755);
+    ::mkdir(stream_directory.c_str(), 0755);
+    new_stream->detector.storage.event_directory = stream_directory + "/";
+
+    EventCallbackType callback = this->event_callback;
+    new_stream->detector.storage.setEventStorageCallback([callback, stream_id](Event<DataPointType> &event) {
+        callback(stream_id, event);
+    });
+    new_stream->detector.prepareAnalyzing(&new_stream->queue, &new_stream->meta_data, std::move(strategy));
+
+    this->streams.push_back(std::move(new_stream));
+    return stream_id;
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType> template<typename IteratorType> void
+DetectionServer<EventDetectionStrategyType, DataPointType>::addDataPoints(StreamIdType stream_id, IteratorType begin,
+                                                                          IteratorType end) {
+    Stream &to_fill = this->stream(stream_id);
+    // the stream is scheduled after every chunk, so the queue is drained while the rest is added
+    const long chunk_size = static_cast<long>(std::max<unsigned long>(to_fill.queue.getQueueMaxSize() / 2, 1));
+    while (begin != end) {
+        IteratorType chunk_end = begin + std::min<long>(chunk_size, static_cast<long>(end - begin));
+        to_fill.queue.addDataPoints(begin, chunk_end);
+        begin = chunk_end;
+        this->schedule(&to_fill);
+    }
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType> void
+DetectionServer<EventDetectionStrategyType, DataPointType>::endStream(StreamIdType stream_id) {
+    Stream &to_end = this->stream(stream_id);
+    to_end.queue.notifyStreamEnd();
+    this->schedule(&to_end);
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType> void
+DetectionServer<EventDetectionStrategyType, DataPointType>::waitUntilDone() {
+    std::unique_lock<std::mutex> server_lock(this->server_mutex);
+    this->streams_done.wait(server_lock, [this]() { return this->finished_streams == this->streams.size(); });
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType> void
+DetectionServer<EventDetectionStrategyType, DataPointType>::setEventCallback(EventCallbackType callback) {
+    std::lock_guard<std::mutex> server_lock(this->server_mutex);
+    if (!this->streams.empty()) {
+        std::cerr << "The event callback has to be set before the first stream is added" << std::endl;
+        throw std::exception();
+    }
+    this->event_callback = std::move(callback);
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType> DynamicStreamMetaData &
+DetectionServer<EventDetectionStrategyType, DataPointType>::streamMetaData(StreamIdType stream_id) {
+    return this->stream(stream_id).meta_data;
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType> EventStorage<DataPointType> &
+DetectionServer<EventDetectionStrategyType, DataPointType>::streamStorage(StreamIdType stream_id) {
+    return this->stream(stream_id).detector.storage;
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType>
+typename DetectionServer<EventDetectionStrategyType, DataPointType>::Stream &
+DetectionServer<EventDetectionStrategyType, DataPointType>::stream(StreamIdType stream_id) {
+    std::lock_guard<std::mutex> server_lock(this->server_mutex);
+    if (stream_id >= this->streams.size()) {
+        std::cerr << "There is no stream with the id " << stream_id << std::endl;
+        throw std::exception();
+    }
+    return *this->streams[stream_id];
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType> void
+DetectionServer<EventDetectionStrategyType, DataPointType>::schedule(Stream *to_schedule) {
+    bool already_scheduled = false;
+    if (!to_schedule->scheduled.compare_exchange_strong(already_scheduled, true)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> server_lock(this->server_mutex);
+        this->worker_queues[to_schedule->id % this->worker_queues.size()].push_back(to_schedule);
+    }
+    this->work_available.notify_one();
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType> void
+DetectionServer<EventDetectionStrategyType, DataPointType>::work(unsigned int worker) {
+    std::unique_lock<std::mutex> server_lock(this->server_mutex);
+    for (;;) {
+        Stream *to_run = nullptr;
+        this->work_available.wait(server_lock, [this, worker, &to_run]() {
+            return (to_run = this->takeStream(worker)) != nullptr || this->stop_workers;
+        });
+        if (this->stop_workers) {
+            return;
+        }
+        server_lock.unlock();
+        this->runSlice(to_run);
+        server_lock.lock();
+    }
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType>
+typename DetectionServer<EventDetectionStrategyType, DataPointType>::Stream *
+DetectionServer<EventDetectionStrategyType, DataPointType>::takeStream(unsigned int worker) {
+    // the server mutex is held by the caller
+    auto &own_queue = this->worker_queues[worker];
+    if (!own_queue.empty()) {
+        Stream *taken = own_queue.front();
+        own_queue.pop_front();
+        return taken;
+    }
+    for (unsigned int other = 1; other < this->worker_queues.size(); ++other) {
+        auto &other_queue = this->worker_queues[(worker + other) % this->worker_queues.size()];
+        if (!other_queue.empty()) {
+            // the oldest stream has waited longest for its data to be analyzed
+            Stream *stolen = other_queue.front();
+            other_queue.pop_front();
+            return stolen;
+        }
+    }
+    return nullptr;
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType> void
+DetectionServer<EventDetectionStrategyType, DataPointType>::runSlice(Stream *to_run) {
+    if (!to_run->detector.analyzeAvailableDataPoints(this->periods_per_slice)) {
+        // the stream stays marked as scheduled, so it is never run again
+        std::lock_guard<std::mutex> server_lock(this->server_mutex);
+        ++this->finished_streams;
+        this->streams_done.notify_all();
+        return;
+    }
+
+    // the detector may only be used before the stream is released, another worker can take it right after
+    const unsigned long data_points_needed = to_run->detector.dataPointsNeeded();
+    to_run->scheduled = false;
+    // data points that were added while the stream was still marked as scheduled did not schedule it
+    if (to_run->queue.canRead(data_points_needed)) {
+        this->schedule(to_run);
+    }
+}
+
+#endif //SMART_SCREEN_DETECTIONSERVER_H
@@ -7,6 +7,7 @@
 #include "BluedDataPoint.h"
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/optional.hpp>
+#include <boost/serialization/version.hpp>
 #include <boost/date_time/posix_time/time_serialize.hpp>
 
 template<typename DataPointType> class Event {
@@ -49,6 +50,9 @@ namespace boost {
             ar & meta_data.event_time;
             ar & meta_data.label;
             ar & meta_data.power_meta_data;
+            if (version > 0) {
+                ar & meta_data.channel;
+            }
 
         }
         template<class Archive> void serialize(Archive &ar, PowerMetaData &meta_data, const unsigned int version) {
@@ -86,5 +90,7 @@ namespace boost {
     } // namespace serialization
 } // namespace boost
 
+// version 1 added the channel of multi channel detections
+BOOST_CLASS_VERSION(EventMetaData, 1)
 
 #endif //SMART_SCREEN_EVENT_H
@@ -0,0 +1,385 @@
+#ifndef SMART_SCREEN_EVENTARCHIVE_H
+#define SMART_SCREEN_EVENTARCHIVE_H
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <fstream>
+#include <iostream>
+#include <exception>
+#include <type_traits>
+
+#include <sys/stat.h>
+
+#include "MappedFile.h"
+#include "EventMetaData.h"
+#include "Event.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The event archive stores raw little endian data"
+#endif
+
+/**
+ * @brief A read only view of an event that is stored in an EventArchive.
+ *
+ * The data points are not copied, they point into the memory mapped segment. The view is valid as long as the archive it came
+ * from exists. It offers the same iterators as Event, so it can be passed to the FeatureExtractor instead of an Event.
+ */
+template<typename DataPointType> class EventView {
+public:
+    typedef const DataPointType *const_iterator;
+
+    const DataPointType *data_begin = nullptr;
+    const DataPointType *data_end = nullptr;
+    EventMetaData event_meta_data;
+
+    const_iterator before_event_begin() const {
+        return data_begin;
+    }
+
+    const_iterator before_event_end() const {
+        return event_begin();
+    }
+
+    const_iterator event_begin() const {
+        return data_begin + event_meta_data.power_meta_data.data_points_stored_before_event;
+    }
+
+    const_iterator event_end() const {
+        return data_end;
+    }
+
+    Event<DataPointType> toEvent() const {
+        Event<DataPointType> result;
+        result.event_data.assign(data_begin, data_end);
+        result.event_meta_data = event_meta_data;
+        return result;
+    }
+};
+
+/**
+ * @brief Stores events in a few large binary segment files instead of one text archive per event.
+ *
+ * Every event is appended to the current segment as one record: a fixed EventArchiveRecordHeader with the EventMetaData, the
+ * data set start time string and the raw data points. Records are aligned to record_alignment bytes so the data points can be
+ * used in place. When a segment is larger than max_segment_size a new one is started. A separate index file holds one
+ * EventArchiveIndexEntry per event with the segment and the offset of its record. It is written after the record, so a reader
+ * never sees an entry whose record is incomplete.
+ *
+ * Reading maps the segments into memory, view returns an EventView into the mapping and load copies it into an Event. The index
+ * is reread when an unknown event is requested, so an archive can be read while another process is still appending to it.
+ * The archive is not thread safe.
+ */
+template<typename DataPointType> class EventArchive {
+public:
+    explicit EventArchive(const std::string &directory);
+
+    void append(const Event<DataPointType> &event);
+
+    EventView<DataPointType> view(unsigned long event_id);
+
+    Event<DataPointType> load(unsigned long event_id);
+
+    bool contains(unsigned long event_id);
+
+    const std::string &directory() const {
+        return this->archive_directory;
+    }
+
+    /**
+     * @brief Returns true if directory holds an event archive.
+     */
+    static bool exists(const std::string &directory);
+
+public:
+    unsigned long max_segment_size = 256ul * 1024 * 1024;
+
+private:
+    struct EventArchiveRecordHeader {
+        uint32_t magic;
+        uint32_t header_size;
+        uint64_t event_id;
+        uint64_t number_of_data_points;
+        uint64_t data_point_size;
+        // microseconds since the unix epoch, not_a_date_time is stored as the smallest value
+        int64_t event_time;
+        double label;
+        uint32_t has_label;
+        float scale_volts;
+        float scale_amps;
+        float voltage;
+        uint64_t sample_rate;
+        uint64_t frequency;
+        uint64_t max_data_points_in_queue;
+        int32_t data_points_stored_of_event;
+        int32_t data_points_stored_before_event;
+        uint64_t data_set_start_time_length;
+        uint32_t channel;
+        uint32_t has_channel;
+    };
+
+    struct EventArchiveIndexEntry {
+        uint64_t event_id;
+        uint64_t segment;
+        uint64_t offset;
+    };
+
+    enum {
+        record_magic = 0x57455353, // "SSEW"
+        record_alignment = 16
+    };
+
+    static_assert(sizeof(EventArchiveRecordHeader) == 112, "the record header must not contain padding");
+    static_assert(std::is_standard_layout<DataPointType>::value, "data points are stored as raw memory");
+
+    void openForWriting();
+
+    void refreshIndex();
+
+    const MappedFile &mapSegment(uint64_t segment_number, uint64_t needed_size);
+
+    std::string segmentPath(uint64_t segment_number) const;
+
+    std::string indexPath() const {
+        return indexPath(this->archive_directory);
+    }
+
+    static std::string indexPath(const std::string &directory) {
+        return directory + "/events.index";
+    }
+
+    static uint64_t padding(uint64_t size) {
+        return (record_alignment - size % record_alignment) % record_alignment;
+    }
+
+    static int64_t timeToMicroseconds(const EventMetaData::TimeType &time);
+
+    static EventMetaData::TimeType microsecondsToTime(int64_t microseconds);
+
+private:
+    std::string archive_directory;
+
+    bool writing = false;
+    std::ofstream segment_stream;
+    std::ofstream index_stream;
+    uint64_t segment = 0;
+    uint64_t segment_size = 0;
+
+    std::unordered_map<unsigned long, EventArchiveIndexEntry> index;
+    std::streamoff index_bytes_read = 0;
+    std::map<uint64_t, MappedFile> segments;
+    // views may still point into mappings that were replaced by larger ones, so those are kept until the archive is destroyed
+    std::vector<MappedFile> replaced_segments;
+};
+
+template<typename DataPointType>
+EventArchive<DataPointType>::EventArchive(const std::string &directory) : archive_directory(directory) {}
+
+template<typename DataPointType> bool EventArchive<DataPointType>::exists(const std::string &directory) {
+    struct stat file_status;
+    return ::stat(indexPath(directory).c_str(), &file_status) == 0;
+}
+
+template<typename DataPointType> std::string EventArchive<DataPointType>::segmentPath(uint64_t segment_number) const {
+    const size_t pad_width = 5;
+    auto number = std::to_string(segment_number);
+    if (number.size() < pad_width) {
+        number = std::string(pad_width - number.size(), '0') + number;
+    }
+    return this->archive_directory + "/events_" + number + ".segment";
+}
+
+template<typename DataPointType> void EventArchive<DataPointType>::openForWriting() {
+    // continue an existing archive in its last segment
+    std::ifstream existing_index(indexPath(), std::ios::binary | std::ios::ate);
+    if (existing_index.good() && existing_index.tellg() >= static_cast<std::streamoff>(sizeof(EventArchiveIndexEntry))) {
+        EventArchiveIndexEntry last_entry;
+        existing_index.seekg(-static_cast<std::streamoff>(sizeof(EventArchiveIndexEntry)), std::ios::end);
+        existing_index.read(reinterpret_cast<char *>(&last_entry), sizeof(last_entry));
+        this->segment = last_entry.segment;
+    }
+    existing_index.close();
+
+    this->segment_stream.open(segmentPath(this->segment), std::ios::binary | std::ios::app);
+    this->index_stream.open(indexPath(), std::ios::binary | std::ios::app);
+    if (!this->segment_stream.good() || !this->index_stream.good()) {
+        std::cerr << "Could not open event archive in: " << this->archive_directory << std::endl;
+        throw std::exception();
+    }
+    this->segment_stream.seekp(0, std::ios::end);
+    this->segment_size = static_cast<uint64_t>(this->segment_stream.tellp());
+    this->writing = true;
+}
+
+template<typename DataPointType> void EventArchive<DataPointType>::append(const Event<DataPointType> &event) {
+    if (!this->writing) {
+        openForWriting();
+    }
+    if (this->segment_size >= this->max_segment_size) {
+        this->segment_stream.close();
+        ++this->segment;
+        this->segment_size = 0;
+        this->segment_stream.open(segmentPath(this->segment), std::ios::binary | std::ios::trunc);
+        if (!this->segment_stream.good()) {
+            std::cerr << "Could not open path: " << segmentPath(this->segment) << std::endl;
+            throw std::exception();
+        }
+    }
+
+    const EventMetaData &meta_data = event.event_meta_data;
+    const PowerMetaData &power_meta_data = meta_data.power_meta_data;
+    const std::string &start_time = power_meta_data.data_set_start_time;
+
+    EventArchiveRecordHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = record_magic;
+    header.header_size = static_cast<uint32_t>(sizeof(header) + start_time.size() +
+                                               padding(sizeof(header) + start_time.size()));
+    header.event_id = meta_data.event_id;
+    header.number_of_data_points = event.event_data.size();
+    header.data_point_size = sizeof(DataPointType);
+    header.event_time = timeToMicroseconds(meta_data.event_time);
+    header.has_label = meta_data.label ? 1 : 0;
+    header.label = meta_data.label ? *meta_data.label : 0;
+    header.scale_volts = power_meta_data.scale_volts;
+    header.scale_amps = power_meta_data.scale_amps;
+    header.voltage = power_meta_data.voltage;
+    header.sample_rate = power_meta_data.sample_rate;
+    header.frequency = power_meta_data.frequency;
+    header.max_data_points_in_queue = power_meta_data.max_data_points_in_queue;
+    header.data_points_stored_of_event = power_meta_data.data_points_stored_of_event;
+    header.data_points_stored_before_event = power_meta_data.data_points_stored_before_event;
+    header.data_set_start_time_length = start_time.size();
+    header.has_channel = meta_data.channel ? 1 : 0;
+    header.channel = meta_data.channel ? *meta_data.channel : 0;
+
+    const char zeros[record_alignment] = {};
+    const uint64_t data_size = event.event_data.size() * sizeof(DataPointType);
+
+    this->segment_stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    this->segment_stream.write(start_time.data(), start_time.size());
+    this->segment_stream.write(zeros, padding(sizeof(header) + start_time.size()));
+    this->segment_stream.write(reinterpret_cast<const char *>(event.event_data.data()), data_size);
+    this->segment_stream.write(zeros, padding(data_size));
+    this->segment_stream.flush();
+
+    EventArchiveIndexEntry entry{meta_data.event_id, this->segment, this->segment_size};
+    this->index_stream.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    this->index_stream.flush();
+    if (!this->segment_stream.good() || !this->index_stream.good()) {
+        std::cerr << "Could not write event " << meta_data.event_id << " to the event archive in: "
+                  << this->archive_directory << std::endl;
+        throw std::exception();
+    }
+    this->segment_size += header.header_size + data_size + padding(data_size);
+}
+
+template<typename DataPointType> void EventArchive<DataPointType>::refreshIndex() {
+    std::ifstream index_file(indexPath(), std::ios::binary);
+    if (!index_file.good()) {
+        return;
+    }
+    index_file.seekg(this->index_bytes_read);
+    EventArchiveIndexEntry entry;
+    while (index_file.read(reinterpret_cast<char *>(&entry), sizeof(entry))) {
+        this->index[entry.event_id] = entry;
+        this->index_bytes_read += sizeof(entry);
+    }
+}
+
+template<typename DataPointType> bool EventArchive<DataPointType>::contains(unsigned long event_id) {
+    if (this->index.count(event_id) == 0) {
+        refreshIndex();
+    }
+    return this->index.count(event_id) != 0;
+}
+
+template<typename DataPointType> const MappedFile &
+EventArchive<DataPointType>::mapSegment(uint64_t segment_number, uint64_t needed_size) {
+    auto mapping = this->segments.find(segment_number);
+    if (mapping == this->segments.end()) {
+        mapping = this->segments.emplace(segment_number, MappedFile(segmentPath(segment_number))).first;
+    } else if (mapping->second.size() < needed_size) {
+        // the segment grew since it was mapped
+        this->replaced_segments.push_back(std::move(mapping->second));
+        mapping->second = MappedFile(segmentPath(segment_number));
+    }
+    if (mapping->second.size() < needed_size) {
+        std::cerr << "Segment " << segmentPath(segment_number) << " is truncated" << std::endl;
+        throw std::exception();
+    }
+    return mapping->second;
+}
+
+template<typename DataPointType> EventView<DataPointType> EventArchive<DataPointType>::view(unsigned long event_id) {
+    if (!contains(event_id)) {
+        std::cerr << "Event " << event_id << " is not in the event archive in: " << this->archive_directory << std::endl;
+        throw std::exception();
+    }
+    const EventArchiveIndexEntry &entry = this->index[event_id];
+
+    const MappedFile *mapping = &mapSegment(entry.segment, entry.offset + sizeof(EventArchiveRecordHeader));
+    EventArchiveRecordHeader header;
+    std::memcpy(&header, mapping->data() + entry.offset, sizeof(header));
+    if (header.magic != record_magic || header.event_id != event_id || header.data_point_size != sizeof(DataPointType)) {
+        std::cerr << "Event " << event_id << " in " << segmentPath(entry.segment) << " is corrupt or of another data point type"
+                  << std::endl;
+        throw std::exception();
+    }
+    const uint64_t data_offset = entry.offset + header.header_size;
+    mapping = &mapSegment(entry.segment, data_offset + header.number_of_data_points * sizeof(DataPointType));
+
+    EventView<DataPointType> result;
+    result.data_begin = reinterpret_cast<const DataPointType *>(mapping->data() + data_offset);
+    result.data_end = result.data_begin + header.number_of_data_points;
+
+    EventMetaData &meta_data = result.event_meta_data;
+    meta_data.event_id = header.event_id;
+    meta_data.event_time = microsecondsToTime(header.event_time);
+    if (header.has_label) {
+        meta_data.label = header.label;
+    }
+    if (header.has_channel) {
+        meta_data.channel = header.channel;
+    }
+    PowerMetaData &power_meta_data = meta_data.power_meta_data;
+    power_meta_data.scale_volts = header.scale_volts;
+    power_meta_data.scale_amps = header.scale_amps;
+    power_meta_data.voltage = header.voltage;
+    power_meta_data.sample_rate = header.sample_rate;
+    power_meta_data.frequency = header.frequency;
+    power_meta_data.max_data_points_in_queue = header.max_data_points_in_queue;
+    power_meta_data.data_points_stored_of_event = header.data_points_stored_of_event;
+    power_meta_data.data_points_stored_before_event = header.data_points_stored_before_event;
+    power_meta_data.data_set_start_time.assign(mapping->data() + entry.offset + sizeof(header),
+                                               header.data_set_start_time_length);
+    return result;
+}
+
+template<typename DataPointType> Event<DataPointType> EventArchive<DataPointType>::load(unsigned long event_id) {
+    return view(event_id).toEvent();
+}
+
+template<typename DataPointType> int64_t
+EventArchive<DataPointType>::timeToMicroseconds(const EventMetaData::TimeType &time) {
+    if (time.is_special()) {
+        return std::numeric_limits<int64_t>::min();
+    }
+    const EventMetaData::TimeType epoch(boost::gregorian::date(1970, 1, 1));
+    return (time - epoch).total_microseconds();
+}
+
+template<typename DataPointType> EventMetaData::TimeType
+EventArchive<DataPointType>::microsecondsToTime(int64_t microseconds) {
+    if (microseconds == std::numeric_limits<int64_t>::min()) {
+        return EventMetaData::TimeType();
+    }
+    const EventMetaData::TimeType epoch(boost::gregorian::date(1970, 1, 1));
+    return epoch + EventMetaData::USDurationType(microseconds);
+}
+
+#endif //SMART_SCREEN_EVENTARCHIVE_H
@@ -6,13 +6,15 @@
 #include <memory>
 #include <thread>
 #include <cassert>
+#include <algorithm>
 #include "EventMetaData.h"
 #include "EventStorage.h"
 #include <utility>
 #include "DefaultEventDetectionStrategy.h"
 
 
-template<typename EventDetectionStrategyType = DefaultEventDetectionStrategy, typename DataPointType = DefaultDataPoint> class EventDetector {
+template<typename EventDetectionStrategyType = DefaultEventDetectionStrategy, typename DataPointType = DefaultDataPoint,
+        typename QueuePolicy = LockedQueuePolicy> class EventDetector {
 public:
     /**
      * @brief This function spawns a thread that reads data from a DefaultDataManager and detects events in it. If the thread is already running the program will wait until it has ended.
@@ -20,9 +22,28 @@ public:
      * @param meta_data
      * @param time
      */
-    void startAnalyzing(AsyncDataQueue<DataPointType> *input_data_manager, DynamicStreamMetaData *meta_data,
+    void startAnalyzing(AsyncDataQueue<DataPointType, QueuePolicy> *input_data_manager, DynamicStreamMetaData *meta_data,
                         EventDetectionStrategyType strategy = EventDetectionStrategyType());
 
+    /**
+     * @brief Prepares the detection like startAnalyzing, but does not spawn a thread. The caller drives the detection with
+     * analyzeAvailableDataPoints, so one thread can serve many detectors.
+     */
+    void prepareAnalyzing(AsyncDataQueue<DataPointType, QueuePolicy> *input_data_manager, DynamicStreamMetaData *meta_data,
+                          EventDetectionStrategyType strategy = EventDetectionStrategyType());
+
+    /**
+     * @brief Analyzes at most max_periods periods that are already in the queue and stores the detected events, without
+     * waiting for more data.
+     * @return Returns false once the stream has ended and all of its data points are analyzed, or the detector was stopped.
+     */
+    bool analyzeAvailableDataPoints(unsigned long max_periods);
+
+    /**
+     * @brief Returns the number of data points that have to be in the queue before analyzeAvailableDataPoints can continue.
+     */
+    unsigned long dataPointsNeeded() const;
+
     /**
      * @brief Waits until a full period can be read and analyzes it for events. If one is detected it reads additional data until the event can be stored
      */
@@ -43,9 +64,11 @@ public:
 private:
     void run();
 
-    bool readBuffer(DataPointType *data_point);
+    bool readBuffer();
 
-    bool detectEvent(DataPointType *tested_period);
+    void releaseBuffer();
+
+    bool detectEvent(const DataPointType *tested_period);
 
     void storeEvent();
 
@@ -55,31 +78,43 @@ public:
 private:
     bool continue_analyzing = true;
     bool stop_now = false;
+    // set by analyzeAvailableDataPoints when the data of a detected event is not in the queue yet
+    bool event_pending = false;
 
     EventDetectionStrategyType event_detection_strategy;
     DynamicStreamMetaData *dynamic_meta_data;
 
     PowerMetaData power_meta_data;
-    AsyncDataQueue<DataPointType> *data_manager;
-    DynamicStreamMetaData::DataPointIdType data_points_read = -1;
+    AsyncDataQueue<DataPointType, QueuePolicy> *data_manager;
+    DynamicStreamMetaData::DataPointIdType data_points_read = 0;
+    DynamicStreamMetaData::DataPointIdType event_data_point = 0;
     unsigned long buffer_length;
-    std::unique_ptr<DataPointType[]> electrical_period_buffer;
+    DataPointWindow<DataPointType> current_period;
 
 
     std::thread runner;
 };
 
-template<typename EventDetectionStrategyType, typename DataPointType> void
-EventDetector<EventDetectionStrategyType, DataPointType>::startAnalyzing(AsyncDataQueue<DataPointType> *input_data_manager,
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> void
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::startAnalyzing(AsyncDataQueue<DataPointType, QueuePolicy> *input_data_manager,
                                                                          DynamicStreamMetaData *meta_data,
                                                                          EventDetectionStrategyType strategy) {
-    assert(input_data_manager != nullptr);
-    assert(meta_data != nullptr);
-
     // block until the thread has ended. We can't have 2 threads writing into the buffers at the same time.
     this->join();
 
+    this->prepareAnalyzing(input_data_manager, meta_data, std::move(strategy));
+    runner = std::thread(&EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::run, this);
+}
+
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> void
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::prepareAnalyzing(AsyncDataQueue<DataPointType, QueuePolicy> *input_data_manager,
+                                                                            DynamicStreamMetaData *meta_data,
+                                                                            EventDetectionStrategyType strategy) {
+    assert(input_data_manager != nullptr);
+    assert(meta_data != nullptr);
+
     this->continue_analyzing = true;
+    this->event_pending = false;
     this->stop_now = false;
     this->data_manager = input_data_manager;
     this->dynamic_meta_data = meta_data;
@@ -88,73 +123,128 @@ EventDetector<EventDetectionStrategyType, DataPointType>::startAnalyzing(AsyncDa
     this->data_points_read = this->power_meta_data.data_points_stored_before_event;
 
     this->buffer_length = power_meta_data.dataPointsPerPeriod();
+}
 
-    // create buffer for the electrical periods
-    this->electrical_period_buffer = std::unique_ptr<DataPointType[]>(new DataPointType[buffer_length]);
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> bool
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::analyzeAvailableDataPoints(unsigned long max_periods) {
+    for (unsigned long period = 0; period < max_periods && this->continue_analyzing; ++period) {
+        if (!this->data_manager->canRead(this->dataPointsNeeded())) {
+            return true;
+        }
+        if (this->event_pending) {
+            this->event_pending = false;
+            this->storeEvent();
+            continue;
+        }
+        if (!this->readBuffer()) {
+            this->continue_analyzing = false;
+            break;
+        }
+        bool event_detected = this->detectEvent(this->current_period.begin());
+        this->releaseBuffer();
+        this->event_pending = event_detected;
+    }
+    return this->continue_analyzing;
+}
 
-    runner = std::thread(&EventDetector<EventDetectionStrategyType, DataPointType>::run, this);
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> unsigned long
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::dataPointsNeeded() const {
+    if (this->event_pending) {
+        return static_cast<unsigned long>(std::max(this->power_meta_data.data_points_stored_before_event +
+                                                   this->power_meta_data.data_points_stored_of_event, 0));
+    }
+    return this->buffer_length + static_cast<unsigned long>(this->power_meta_data.data_points_stored_before_event);
 }
 
-template<typename EventDetectionStrategyType, typename DataPointType> void
-EventDetector<EventDetectionStrategyType, DataPointType>::run() {
-    DataPointType *buffer_current_period = this->electrical_period_buffer.get();
-    while (this->readBuffer(buffer_current_period) && this->continue_analyzing) {
-        if (this->detectEvent(buffer_current_period)) {
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> void
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::run() {
+    while (this->continue_analyzing && this->readBuffer()) {
+        bool event_detected = this->detectEvent(this->current_period.begin());
+        // the period has to leave the queue before the event data is popped from it
+        this->releaseBuffer();
+        if (event_detected) {
             this->storeEvent();
         }
     }
 }
 
-template<typename EventDetectionStrategyType, typename DataPointType> bool
-EventDetector<EventDetectionStrategyType, DataPointType>::readBuffer(DataPointType *data_point) {
-    DataPointType *buffer_end = data_point + this->buffer_length;
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> bool
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::readBuffer() {
+    this->current_period = data_manager->peekDataPoints(this->buffer_length,
+                                                        static_cast<unsigned long> (this->power_meta_data.data_points_stored_before_event));
+    this->data_points_read += this->buffer_length;
+    if (this->current_period.size() != this->buffer_length) {
+        this->releaseBuffer();
+        return false;
+    }
+    return true;
+}
 
-    DataPointType *data_end = data_manager->getDataPoints(data_point, buffer_end,
-                                                          static_cast<unsigned long> (this->power_meta_data.data_points_stored_before_event));
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> void
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::releaseBuffer() {
+    this->current_period = DataPointWindow<DataPointType>();
     data_manager->nextDataPoints(this->buffer_length);
-    this->data_points_read += this->buffer_length;
-    return data_end == buffer_end;
 }
 
-template<typename EventDetectionStrategyType, typename DataPointType> bool
-EventDetector<EventDetectionStrategyType, DataPointType>::detectEvent(DataPointType *tested_period) {
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> bool
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::detectEvent(const DataPointType *tested_period) {
     if (this->event_detection_strategy.detectEvent(tested_period, tested_period + this->buffer_length,
                                                    this->buffer_length)) {
+        // data_points_read already points behind the tested period
+        this->event_data_point = this->data_points_read - this->buffer_length +
+                                 this->event_detection_strategy.detectedEventPosition();
 #ifdef DEBUG_OUTPUT
-        std::cout << "time: " << this->dynamic_meta_data->getDataPointTime(this->data_points_read) << std::endl;
+        std::cout << "time: " << this->dynamic_meta_data->getDataPointTime(this->event_data_point) << std::endl;
 #endif
         return true;
     }
     return false;
 }
 
-template<typename EventDetectionStrategyType, typename DataPointType> void
-EventDetector<EventDetectionStrategyType, DataPointType>::storeEvent() {
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> void
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::storeEvent() {
     // Make sure we want to store at least one period of data
     if (this->power_meta_data.data_points_stored_of_event <= 0 || this->stop_now) { return; }
 
 
     int total_data_points_stored = this->dynamic_meta_data->getFixedPowerMetaData().data_points_stored_before_event;
     total_data_points_stored += this->dynamic_meta_data->getFixedPowerMetaData().data_points_stored_of_event;
-    std::unique_ptr<DataPointType[]> data_points(new DataPointType[total_data_points_stored]);
+    std::vector<DataPointType> data_points(total_data_points_stored);
 
 
-    this->data_manager->popDataPoints(data_points.get(), data_points.get() + total_data_points_stored);
-    EventMetaData meta_data(this->dynamic_meta_data->getDataPointTime(this->data_points_read),
+    this->data_manager->popDataPoints(data_points.begin(), data_points.end());
+    EventMetaData meta_data(this->dynamic_meta_data->getDataPointTime(this->event_data_point),
                             this->dynamic_meta_data->getFixedPowerMetaData());
-    this->storage.storeEvent(data_points.get(), data_points.get() + total_data_points_stored, meta_data);
+    unsigned long detected_channels = this->event_detection_strategy.detectedChannels();
+    if (detected_channels == 0) {
+        // the buffer is handed over to the storage, with async persistence the disk is written by another thread
+        this->storage.storeEvent(std::move(data_points), meta_data);
+    }
+    // strategies that test every channel on its own report the channels, each one is stored as an event of its own
+    for (unsigned int channel = 0; detected_channels != 0; ++channel, detected_channels >>= 1) {
+        if ((detected_channels & 1) == 0) {
+            continue;
+        }
+        meta_data.channel = channel;
+        // only the last channel can take over the buffer, the others are stored from a copy
+        if (detected_channels == 1) {
+            this->storage.storeEvent(std::move(data_points), meta_data);
+        } else {
+            this->storage.storeEvent(std::vector<DataPointType>(data_points), meta_data);
+        }
+    }
 
     this->data_points_read += total_data_points_stored;
 }
 
-template<typename EventDetectionStrategyType, typename DataPointType> void
-EventDetector<EventDetectionStrategyType, DataPointType>::stopGracefully() {
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> void
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::stopGracefully() {
     this->continue_analyzing = false;
     this->join();
 }
 
-template<typename EventDetectionStrategyType, typename DataPointType> void
-EventDetector<EventDetectionStrategyType, DataPointType>::stopNow() {
+template<typename EventDetectionStrategyType, typename DataPointType, typename QueuePolicy> void
+EventDetector<EventDetectionStrategyType, DataPointType, QueuePolicy>::stopNow() {
     this->continue_analyzing = false;
     this->stop_now = true;
 
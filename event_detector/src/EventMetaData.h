@@ -16,6 +16,10 @@ struct EventMetaData {
     typedef double LabelType;
     unsigned long event_id;
     boost::optional<LabelType> label;
+    /**
+     * @brief The channel the event was detected on, only set by strategies that test several channels independently.
+     */
+    boost::optional<unsigned int> channel;
     PowerMetaData power_meta_data;
     EventMetaData() {}
 
@@ -5,6 +5,8 @@
 #include <string>
 #include <fstream>
 #include <functional>
+#include <memory>
+#include <atomic>
 
 
 #include <boost/archive/text_oarchive.hpp>
@@ -13,27 +15,67 @@
 #include "DefaultDataPoint.h"
 #include "EventMetaData.h"
 #include "Event.h"
+#include "EventArchive.h"
+#include "AsyncEventWriter.h"
 
+namespace EventStorageFormat {
+    enum EventStorageFormat {
+        TextArchive, /**< One boost text archive and one CSV file per event. */
+        BinaryArchive /**< All events in one segmented binary EventArchive. */
+    };
+}
 
 template<typename DataPointType=DefaultDataPoint> class EventStorage {
 public:
     template<typename IteratorType> unsigned long
     storeEvent(IteratorType begin, const IteratorType end, const EventMetaData &meta_data);
 
+    /**
+     * @brief Stores an event and takes over its data points, so they do not have to be copied.
+     */
+    unsigned long storeEvent(std::vector<DataPointType> &&event_data, const EventMetaData &meta_data);
+
     template<typename IteratorType> void
     storeFeatureVector(IteratorType begin, const IteratorType end, unsigned long event_uuid);
 
     Event<DataPointType> loadEvent(unsigned long event_uuid);
 
+    /**
+     * @brief Returns a view of the event that does not copy its data points. Only supported by the BinaryArchive format.
+     */
+    EventView<DataPointType> viewEvent(unsigned long event_uuid);
+
+    /**
+     * @brief Switches to the BinaryArchive format if the event directory holds an event archive.
+     * @return Returns true if the directory holds an event archive.
+     */
+    bool useBinaryArchiveIfPresent();
+
     void setEventStorageCallback(std::function<void(Event<DataPointType> &)> callBack);
 
+    /**
+     * @brief From now on the events are written to disk by a separate thread. The callback is still called by the thread that
+     * stores the event.
+     *
+     * Spilled events are written to a binary archive in the "spill" subdirectory of the event directory, loadEvent finds them there.
+     *
+     * @param max_pending_events Number of events that may wait for the writer before the overflow policy applies.
+     */
+    void startAsyncPersistence(unsigned long max_pending_events = 64,
+                               PersistenceOverflowPolicy::PersistenceOverflowPolicy overflow_policy = PersistenceOverflowPolicy::Block);
+
+    /**
+     * @brief Blocks until all stored events are written to disk.
+     */
+    void waitUntilPersisted();
+
 
 private:
     std::function<void(Event<DataPointType> &)> callback = [](Event<DataPointType> &) {};
 
-    template<typename IteratorType> void
-    writeToFile(IteratorType begin, const IteratorType end, const std::string &file_name,
-                const EventMetaData &meta_data, const unsigned long id);
+    void writeToFile(std::vector<DataPointType> &&event_data, const EventMetaData &meta_data, const unsigned long id);
+
+    void persistEvent(const Event<DataPointType> &event, bool store_csv);
 
     template<typename IteratorType> void
     writeToCSV(IteratorType begin, const IteratorType end, const std::string &file_name);
@@ -47,9 +89,21 @@ private:
 
     std::string uuidToString(unsigned long uuid);
 
+    EventArchive<DataPointType> &archive();
+
+    EventArchive<DataPointType> &spillArchive();
+
+    bool isSpilled(unsigned long event_uuid);
+
 public:
     std::string event_directory = "events/";
+    EventStorageFormat::EventStorageFormat storage_format = EventStorageFormat::TextArchive;
 private:
+    std::unique_ptr<EventArchive<DataPointType>> event_archive;
+    std::unique_ptr<EventArchive<DataPointType>> spill_archive;
+    // declared last, so the writer thread is stopped before the archives it writes to are destroyed
+    std::unique_ptr<AsyncEventWriter<DataPointType>> async_writer;
+
     enum {
         buffer_size = 256
     };
@@ -57,18 +111,25 @@ private:
 
 template<typename DataPointType> template<typename IteratorType> unsigned long
 EventStorage<DataPointType>::storeEvent(IteratorType begin, const IteratorType end, const EventMetaData &meta_data) {
-    static unsigned long uuid = 0;
-    writeToFile<IteratorType>(begin, end, createFilePath(uuid), meta_data, uuid);
-    return uuid++;
+    return storeEvent(eventDataToVector<IteratorType>(begin, end), meta_data);
 }
 
-template<typename DataPointType> template<typename IteratorType> void
-EventStorage<DataPointType>::writeToFile(IteratorType begin, const IteratorType end, const std::string &file_name,
-                                         const EventMetaData &meta_data, const unsigned long id) {
+template<typename DataPointType> unsigned long
+EventStorage<DataPointType>::storeEvent(std::vector<DataPointType> &&event_data, const EventMetaData &meta_data) {
+    // shared by all storages, the detectors of a DetectionServer store their events from several threads
+    static std::atomic<unsigned long> uuid{0};
+    const unsigned long event_uuid = uuid++;
+    writeToFile(std::move(event_data), meta_data, event_uuid);
+    return event_uuid;
+}
+
+template<typename DataPointType> void
+EventStorage<DataPointType>::writeToFile(std::vector<DataPointType> &&event_data, const EventMetaData &meta_data,
+                                         const unsigned long id) {
 
     Event<DataPointType> event;
 
-    event.event_data = eventDataToVector<IteratorType>(begin, end);
+    event.event_data = std::move(event_data);
     event.event_meta_data = meta_data;
     event.event_meta_data.event_id = id;
 
@@ -76,18 +137,58 @@ EventStorage<DataPointType>::writeToFile(IteratorType begin, const IteratorType
     this->callback(event);
 
 #ifndef DONT_STORE_ANYTHING
-    this->storeEventDataToCSV(event);
+    if (this->async_writer) {
+        this->async_writer->push(std::move(event));
+        return;
+    }
+    this->persistEvent(event, true);
+#endif
 
-    std::ofstream out_stream(file_name);
+}
+
+template<typename DataPointType> void
+EventStorage<DataPointType>::persistEvent(const Event<DataPointType> &event, bool store_csv) {
+    if (this->storage_format == EventStorageFormat::BinaryArchive) {
+        this->archive().append(event);
+        return;
+    }
+    if (store_csv) {
+        this->storeEventDataToCSV(event);
+    }
+
+    std::ofstream out_stream(createFilePath(event.event_meta_data.event_id));
     boost::archive::text_oarchive oa(out_stream);
     // write class instance to archive
     oa << event;
     out_stream.close();
-#endif
+}
 
+template<typename DataPointType> void
+EventStorage<DataPointType>::startAsyncPersistence(unsigned long max_pending_events,
+                                                   PersistenceOverflowPolicy::PersistenceOverflowPolicy overflow_policy) {
+    this->async_writer.reset();
+    this->async_writer.reset(new AsyncEventWriter<DataPointType>(
+            [this](const Event<DataPointType> &event, bool store_csv) {
+                this->persistEvent(event, store_csv);
+            },
+            [this](const Event<DataPointType> &event) {
+                this->spillArchive().append(event);
+            }, max_pending_events, overflow_policy));
+}
+
+template<typename DataPointType> void EventStorage<DataPointType>::waitUntilPersisted() {
+    if (this->async_writer) {
+        this->async_writer->waitUntilEmpty();
+    }
 }
 
 template<typename DataPointType> Event<DataPointType> EventStorage<DataPointType>::loadEvent(unsigned long event_uuid) {
+    if (this->isSpilled(event_uuid)) {
+        return this->spillArchive().load(event_uuid);
+    }
+    if (this->storage_format == EventStorageFormat::BinaryArchive) {
+        return this->archive().load(event_uuid);
+    }
     std::string file_path = createFilePath(event_uuid);
 
     std::ifstream ifs(file_path);
@@ -99,6 +200,55 @@ template<typename DataPointType> Event<DataPointType> EventStorage<DataPointType
     return result;
 }
 
+template<typename DataPointType> EventView<DataPointType>
+EventStorage<DataPointType>::viewEvent(unsigned long event_uuid) {
+    if (this->storage_format != EventStorageFormat::BinaryArchive) {
+        std::cerr << "Events can only be viewed in place with the binary archive format" << std::endl;
+        throw std::exception();
+    }
+    if (this->isSpilled(event_uuid)) {
+        return this->spillArchive().view(event_uuid);
+    }
+    return this->archive().view(event_uuid);
+}
+
+template<typename DataPointType> bool EventStorage<DataPointType>::useBinaryArchiveIfPresent() {
+    if (!EventArchive<DataPointType>::exists(this->event_directory)) {
+        return false;
+    }
+    this->storage_format = EventStorageFormat::BinaryArchive;
+    return true;
+}
+
+template<typename DataPointType> EventArchive<DataPointType> &EventStorage<DataPointType>::archive() {
+    // the directory is a public member, so it may have changed since the archive was opened
+    if (!this->event_archive || this->event_archive->directory() != this->event_directory) {
+        this->event_archive.reset(new EventArchive<DataPointType>(this->event_directory));
+    }
+    return *this->event_archive;
+}
+
+template<typename DataPointType> EventArchive<DataPointType> &EventStorage<DataPointType>::spillArchive() {
+    const std::string spill_directory = this->event_directory + "/spill";
+    if (!this->spill_archive || this->spill_archive->directory() != spill_directory) {
+        ::mkdir(spill_directory.c_str(), 0755);
+        this->spill_archive.reset(new EventArchive<DataPointType>(spill_directory));
+    }
+    return *this->spill_archive;
+}
+
+template<typename DataPointType> bool EventStorage<DataPointType>::isSpilled(unsigned long event_uuid) {
+    if (!this->spill_archive && !EventArchive<DataPointType>::exists(this->event_directory + "/spill")) {
+        return false;
+    }
+    // an event that was spilled may have been stored again by a later run, the primary storage wins
+    if (this->storage_format == EventStorageFormat::BinaryArchive ? this->archive().contains(event_uuid) :
+        std::ifstream(createFilePath(event_uuid)).good()) {
+        return false;
+    }
+    return this->spillArchive().contains(event_uuid);
+}
+
 template<typename DataPointType>
 
 template<typename IteratorType> std::vector<DataPointType>
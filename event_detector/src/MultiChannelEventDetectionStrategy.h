@@ -0,0 +1,97 @@
+#ifndef SMART_SCREEN_MULTICHANNELEVENTDETECTIONSTRATEGY_H
+#define SMART_SCREEN_MULTICHANNELEVENTDETECTIONSTRATEGY_H
+
+#include <cmath>
+
+/**
+ * @brief Applies the RMS step criterion of the DefaultEventDetectionStrategy to every channel of a data point independently.
+ *
+ * Instead of the sum returned by ampere() the data point has to offer channels(), a pointer to NumberOfChannels currents.
+ * The sums of squares of all channels are accumulated in one pass over the period, the inner loop over the channels has a
+ * constant length and is vectorized by the compiler. detectedChannels returns a bit mask of the channels the last detected
+ * event was found on, the EventDetector stores one event per channel.
+ */
+template<unsigned int NumberOfChannels> class MultiChannelEventDetectionStrategy {
+public:
+    MultiChannelEventDetectionStrategy(float detection_threshold = 0.2) : threshold(detection_threshold) {}
+
+    template<typename IteratorType> bool
+    detectEvent(IteratorType begin, IteratorType end, unsigned int num_data_points_per_period);
+
+    /**
+     * @brief Returns the position of the sample within the last tested period at which the event was detected. Like the
+     * DefaultEventDetectionStrategy only whole periods are evaluated, so this is always the end of the period.
+     */
+    unsigned long detectedEventPosition() const {
+        return this->period_length;
+    }
+
+    /**
+     * @brief Returns a bit mask of the channels the last event was detected on, bit c is set for channel c.
+     */
+    unsigned long detectedChannels() const {
+        return this->detected_channels;
+    }
+
+private:
+    template<typename IteratorType> void channelRms(IteratorType begin, IteratorType end, float *rms) const;
+
+private:
+    static_assert(NumberOfChannels > 0 && NumberOfChannels <= 8 * sizeof(unsigned long),
+                  "every channel needs a bit in the detected channels");
+
+    unsigned long period_length = 0;
+    unsigned long detected_channels = 0;
+    bool none_detected_yet = true;
+    float previous_rms[NumberOfChannels];
+    float threshold;
+    float previous_weight = 0.4;
+    float current_weight = 1.0f - previous_weight;
+};
+
+template<unsigned int NumberOfChannels> template<typename IteratorType> bool
+MultiChannelEventDetectionStrategy<NumberOfChannels>::detectEvent(IteratorType begin, IteratorType end,
+                                                                  unsigned int num_data_points_per_period) {
+    this->period_length = num_data_points_per_period;
+    this->detected_channels = 0;
+    if (this->none_detected_yet) {
+        channelRms(begin, end, this->previous_rms);
+        this->none_detected_yet = false;
+        return false;
+    }
+
+    float current_rms[NumberOfChannels];
+    channelRms(begin, end, current_rms);
+    for (unsigned int channel = 0; channel < NumberOfChannels; ++channel) {
+        if (current_rms[channel] - this->threshold > this->previous_rms[channel]) {
+            this->detected_channels |= 1ul << channel;
+        } else {
+            this->previous_rms[channel] = this->previous_weight * this->previous_rms[channel] +
+                                          this->current_weight * current_rms[channel];
+        }
+    }
+
+    if (this->detected_channels != 0) {
+        // the EventDetector skips the data points of the event, so every channel starts over with a new baseline
+        this->none_detected_yet = true;
+        return true;
+    }
+    return false;
+}
+
+template<unsigned int NumberOfChannels> template<typename IteratorType> void
+MultiChannelEventDetectionStrategy<NumberOfChannels>::channelRms(IteratorType begin, IteratorType end, float *rms) const {
+    float sum_of_squares[NumberOfChannels] = {};
+    unsigned long number_of_data_points = 0;
+    for (; begin != end; ++begin, ++number_of_data_points) {
+        const auto *values = begin->channels();
+        for (unsigned int channel = 0; channel < NumberOfChannels; ++channel) {
+            sum_of_squares[channel] += values[channel] * values[channel];
+        }
+    }
+    for (unsigned int channel = 0; channel < NumberOfChannels; ++channel) {
+        rms[channel] = number_of_data_points > 0 ? std::sqrt(sum_of_squares[channel] / number_of_data_points) : 0;
+    }
+}
+
+#endif //SMART_SCREEN_MULTICHANNELEVENTDETECTIONSTRATEGY_H
@@ -0,0 +1,143 @@
+#ifndef SMART_SCREEN_SLIDINGWINDOWEVENTDETECTIONSTRATEGY_H
+#define SMART_SCREEN_SLIDINGWINDOWEVENTDETECTIONSTRATEGY_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <iostream>
+
+/**
+ * @brief Detects events with the same RMS step criterion as the DefaultEventDetectionStrategy, but on a window of one period that slides over the samples.
+ *
+ * The sum of squares of the window is updated in O(1) per sample and the criterion is evaluated every evaluation_interval samples,
+ * so events are located with a resolution of evaluation_interval samples instead of one period. The window RMS is compared to a
+ * weighted average of the RMS of the windows that ended one period earlier. To bound the float drift of the running sum it is
+ * recomputed from the stored squares every few windows.
+ */
+class SlidingWindowEventDetectionStrategy {
+public:
+    SlidingWindowEventDetectionStrategy(float detection_threshold = 0.2, unsigned int evaluation_interval = 8) :
+            threshold(detection_threshold), interval(std::max(evaluation_interval, 1u)) {}
+
+    template<typename IteratorType> bool
+    detectEvent(IteratorType begin, IteratorType end, unsigned int num_data_points_per_period);
+
+    /**
+     * @brief Returns the position within the last tested period just behind the window that detected the event. Like the
+     * DefaultEventDetectionStrategy, which returns the end of the period, this is the index of the first sample after the
+     * evaluated samples.
+     */
+    unsigned long detectedEventPosition() const {
+        return this->event_position;
+    }
+
+    /**
+     * @brief Events are detected on the sum of all channels, so no channel is reported.
+     */
+    unsigned long detectedChannels() const {
+        return 0;
+    }
+
+private:
+    void reset(unsigned int window_length);
+
+    bool addSample(float ampere);
+
+    bool evaluate();
+
+    float windowRms() const {
+        return std::sqrt(static_cast<float>(std::max(this->sum_of_squares, 0.0)) / this->squares.size());
+    }
+
+private:
+    enum {
+        windows_between_resummation = 16
+    };
+
+    float threshold;
+    unsigned int interval;
+    float previous_weight = 0.4;
+    float step_previous_weight = 0.4;
+
+    std::vector<float> squares;
+    double sum_of_squares = 0;
+    unsigned long samples_seen = 0;
+    unsigned long samples_since_resummation = 0;
+
+    // RMS values of the last evaluations, used as the baseline once they are one period old
+    std::vector<float> rms_history;
+    unsigned long evaluations = 0;
+    float previous_rms = 0;
+
+    unsigned long event_position = 0;
+};
+
+template<typename IteratorType> bool
+SlidingWindowEventDetectionStrategy::detectEvent(IteratorType begin, IteratorType end,
+                                                 unsigned int num_data_points_per_period) {
+    if (this->squares.size() != num_data_points_per_period) {
+        this->reset(num_data_points_per_period);
+    }
+    unsigned long position = 0;
+    for (; begin != end; ++begin, ++position) {
+        if (this->addSample(begin->ampere())) {
+            // the window ends with the sample at position
+            this->event_position = position + 1;
+#ifdef DEBUG_OUTPUT
+            std::cout << "Detected an event" << std::endl;
+#endif
+            this->reset(num_data_points_per_period);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void SlidingWindowEventDetectionStrategy::reset(unsigned int window_length) {
+    this->squares.assign(window_length, 0.f);
+    this->sum_of_squares = 0;
+    this->samples_seen = 0;
+    this->samples_since_resummation = 0;
+    this->rms_history.assign(std::max(window_length / this->interval, 1u), 0.f);
+    this->evaluations = 0;
+    // keep the time constant of the baseline at one period, no matter how often we evaluate
+    this->step_previous_weight = std::pow(this->previous_weight,
+                                          static_cast<float>(this->interval) / std::max(window_length, 1u));
+}
+
+inline bool SlidingWindowEventDetectionStrategy::addSample(float ampere) {
+    float square = ampere * ampere;
+    float &oldest = this->squares[this->samples_seen % this->squares.size()];
+    this->sum_of_squares += square - oldest;
+    oldest = square;
+    ++this->samples_seen;
+
+    if (++this->samples_since_resummation >= windows_between_resummation * this->squares.size()) {
+        this->sum_of_squares = std::accumulate(this->squares.begin(), this->squares.end(), 0.0);
+        this->samples_since_resummation = 0;
+    }
+
+    if (this->samples_seen < this->squares.size() || this->samples_seen % this->interval != 0) {
+        return false;
+    }
+    return this->evaluate();
+}
+
+inline bool SlidingWindowEventDetectionStrategy::evaluate() {
+    float current_rms = this->windowRms();
+    float &lagged_rms = this->rms_history[this->evaluations % this->rms_history.size()];
+    if (this->evaluations == 0) {
+        this->previous_rms = current_rms;
+    } else if (current_rms - this->threshold > this->previous_rms) {
+        return true;
+    } else if (this->evaluations >= this->rms_history.size()) {
+        this->previous_rms = this->step_previous_weight * this->previous_rms +
+                             (1.0f - this->step_previous_weight) * lagged_rms;
+    }
+    lagged_rms = current_rms;
+    ++this->evaluations;
+    return false;
+}
+
+#endif //SMART_SCREEN_SLIDINGWINDOWEVENTDETECTIONSTRATEGY_H
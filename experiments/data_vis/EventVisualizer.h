@@ -35,6 +35,7 @@ private:
 
 template<typename DataPointType> void EventVisualizer<DataPointType>::setEventStorageDirectory(const std::string &dir) {
     storage.event_directory = dir;
+    storage.useBinaryArchiveIfPresent();
 }
 
 template<typename DataPointType> void
@@ -6,11 +6,14 @@
 
 #include "EventDetector.h"
 #include "DataClassifier.h"
+#include "BatchFeatureExtractor.h"
 
 #include "CrossValidationResult.h"
 #include "SerializeEventLabelManager.h"
 #include "SelectPartitions.h"
 
+template<typename EventType, typename LoadEventFunctionType> void
+classifyEvents(LoadEventFunctionType load_event, DataClassifier<BluedDataPoint> &analyzer);
 
 int main(int argc, char **argv) {
 
@@ -25,24 +28,20 @@ int main(int argc, char **argv) {
     if(argc >=4 ) {
         storage.event_directory = argv[3];
     }
-    auto i = 0;
 
     DataClassifier<BluedDataPoint> analyzer;
     analyzer.startClassification(argv[1]);
-    while (true) {
-        try {
-            auto event = storage.loadEvent(i);
-
-            cout << "." << flush;
-            analyzer.pushEvent(event);
-            ++i;
-        }
-        catch (...) {
-            break;
-        }
 
+    if (storage.useBinaryArchiveIfPresent()) {
+        // the events are used in place in the memory mapped archive
+        classifyEvents<EventView<BluedDataPoint>>([&storage](unsigned long id) {
+            return storage.viewEvent(id);
+        }, analyzer);
+    } else {
+        classifyEvents<Event<BluedDataPoint>>([&storage](unsigned long id) {
+            return storage.loadEvent(id);
+        }, analyzer);
     }
-    cout << endl;
 
 
     analyzer.stopAnalyzingWhenDone();
@@ -56,3 +55,35 @@ int main(int argc, char **argv) {
 
     return 0;
 }
+
+template<typename EventType, typename LoadEventFunctionType> void
+classifyEvents(LoadEventFunctionType load_event, DataClassifier<BluedDataPoint> &analyzer) {
+    using namespace std;
+    unsigned long i = 0;
+    const unsigned long events_per_batch = 256;
+
+    // the features are extracted in parallel, but labeled and classified in the order of the events
+    BatchFeatureExtractor feature_extractor;
+    vector<EventType> batch;
+    bool events_left = true;
+    while (events_left) {
+        batch.clear();
+        while (batch.size() < events_per_batch) {
+            try {
+                batch.push_back(load_event(i));
+
+                cout << "." << flush;
+                ++i;
+            }
+            catch (...) {
+                events_left = false;
+                break;
+            }
+        }
+
+        for (const auto &features: feature_extractor.extractFeatures(batch.begin(), batch.end())) {
+            analyzer.processEventFeatures(features);
+        }
+    }
+    cout << endl;
+}
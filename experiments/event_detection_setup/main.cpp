@@ -7,14 +7,20 @@
 
 #include "EventDetector.h"
 #include "DataClassifier.h"
+#include "SlidingWindowEventDetectionStrategy.h"
 #include <atomic>
 
+template<typename EventDetectionStrategyType> void
+detectEvents(BluedHdf5InputSource &data_source, EventDetectionStrategyType strategy, const char *event_file);
+
 int main(int argc, char **argv) {
 
     using namespace std;
 
     if (argc < 5) {
-        cout << "usage: event_detection_setup <config file> <data file> <event file> <threshold>\n";
+        cout << "usage: event_detection_setup <config file> <data file> <event file> <threshold> [<evaluation interval> [<begin time> <end time>]]\n";
+        cout << "If an evaluation interval other than 0 is given, the sliding window detection is evaluated every <evaluation interval> samples.\n";
+        cout << "If a begin and end time (\"YYYY-MM-DD HH:MM:SS\") are given, only the data recorded in between is analyzed.\n";
         return 0;
     }
 
@@ -31,13 +37,33 @@ int main(int argc, char **argv) {
     data_source.data_manager.setQueueMaxSize(conf.max_data_points_in_queue);
     data_source.meta_data.setFixedPowerMetaData(conf);
 
-    data_source.startReading(argv[2]);
+    if (argc >= 8) {
+        data_source.startReadingTimeRange(argv[2], boost::posix_time::time_from_string(argv[6]),
+                                          boost::posix_time::time_from_string(argv[7]));
+    } else {
+        data_source.startReading(argv[2]);
+    }
+
+    if (argc >= 6 && std::stoul(argv[5]) != 0) {
+        detectEvents(data_source, SlidingWindowEventDetectionStrategy(std::stof(argv[4]), std::stoul(argv[5])), argv[3]);
+    } else {
+        detectEvents(data_source, DefaultEventDetectionStrategy(std::stof(argv[4])), argv[3]);
+    }
 
-    EventDetector<DefaultEventDetectionStrategy, BluedDataPoint> detect;
-    detect.startAnalyzing(&data_source.data_manager, &data_source.meta_data, DefaultEventDetectionStrategy(std::stof(argv[4])));
+    return 0;
+}
+
+template<typename EventDetectionStrategyType> void
+detectEvents(BluedHdf5InputSource &data_source, EventDetectionStrategyType strategy, const char *event_file) {
+    using namespace std;
+
+    EventDetector<EventDetectionStrategyType, BluedDataPoint> detect;
+    detect.storage.storage_format = EventStorageFormat::BinaryArchive;
+    detect.storage.startAsyncPersistence();
+    detect.startAnalyzing(&data_source.data_manager, &data_source.meta_data, strategy);
 
     EventLabelManager<> evl;
-    evl.loadLabelsFromFile(argv[3]);
+    evl.loadLabelsFromFile(event_file);
     mutex evl_mtx;
 
     detect.storage.setEventStorageCallback([&evl, &evl_mtx](Event<BluedDataPoint> &e) {
@@ -55,6 +81,4 @@ int main(int argc, char **argv) {
     cout << "true positives: " << evl.labeled_events.size() << endl;
     cout << "false positives: " << evl.unlabeled_events.size() << endl;
     cout << "false negatives: " << static_cast<long>(evl.labels.size()) - static_cast<long>(evl.labeled_events.size()) << endl;
-
-    return 0;
 }
@@ -14,17 +14,20 @@
 
 using namespace std;
 
+// the main thread is the only writer and the event detector the only reader, so the lock free ring buffer can be used
+typedef AsyncDataQueue<DefaultDataPoint, SpscRingQueuePolicy> SpeedSetupDataQueue;
+
 void fillBuffer(std::vector<DefaultDataPoint> &buffer, const PowerMetaData &conf);
 
 vector<chrono::milliseconds>
-fillDataQueue(AsyncDataQueue<DefaultDataPoint> *to_fill, PowerMetaData conf, std::chrono::milliseconds max_time_diff,
+fillDataQueue(SpeedSetupDataQueue *to_fill, PowerMetaData conf, std::chrono::milliseconds max_time_diff,
               unsigned long number_of_runs);
 
-vector<chrono::milliseconds> fillDataQueue(AsyncDataQueue<DefaultDataPoint> *to_fill, PowerMetaData conf,
+vector<chrono::milliseconds> fillDataQueue(SpeedSetupDataQueue *to_fill, PowerMetaData conf,
                                            std::chrono::milliseconds max_time_diff = std::chrono::milliseconds(1000));
 
 vector<chrono::milliseconds>
-fillDataQueue(AsyncDataQueue<DefaultDataPoint> *to_fill, PowerMetaData conf, std::chrono::milliseconds max_time_diff,
+fillDataQueue(SpeedSetupDataQueue *to_fill, PowerMetaData conf, std::chrono::milliseconds max_time_diff,
               unsigned long number_of_runs) {
     auto buffer_size = conf.sample_rate / 2;
     std::vector<DefaultDataPoint> buffer(buffer_size);
@@ -59,7 +62,7 @@ fillDataQueue(AsyncDataQueue<DefaultDataPoint> *to_fill, PowerMetaData conf, std
 }
 
 vector<chrono::milliseconds>
-fillDataQueue(AsyncDataQueue<DefaultDataPoint> *to_fill, PowerMetaData conf, std::chrono::milliseconds max_time_diff) {
+fillDataQueue(SpeedSetupDataQueue *to_fill, PowerMetaData conf, std::chrono::milliseconds max_time_diff) {
     unsigned long recommended_number_of_runs = (conf.max_data_points_in_queue / conf.sample_rate + 1) * 600;
     cout << "running the setup with " << recommended_number_of_runs << " buffer fills" << endl;
     return fillDataQueue(to_fill, conf, max_time_diff, recommended_number_of_runs);
@@ -99,11 +102,11 @@ int main(int argc, char *argv[]) {
         std::cout << conf << endl;
     DynamicStreamMetaData stream_meta_data;
     stream_meta_data.setFixedPowerMetaData(conf);
-    AsyncDataQueue<DefaultDataPoint> data_queue;
+    SpeedSetupDataQueue data_queue;
     data_queue.setQueueMaxSize(conf.max_data_points_in_queue);
 
 
-    EventDetector<DefaultEventDetectionStrategy, DefaultDataPoint> detect;
+    EventDetector<DefaultEventDetectionStrategy, DefaultDataPoint, SpscRingQueuePolicy> detect;
     detect.startAnalyzing(&data_queue, &stream_meta_data, DefaultEventDetectionStrategy(-1000.0f));
 
     DataClassifier<DefaultDataPoint> analyzer;
@@ -0,0 +1,171 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <time.h>
+
+#include <MappedFile.h>
+#include "daq_interface.h"
+#include "MEDALPacket.h"
+
+using namespace std;
+
+/**
+ * @brief Bookkeeping to relate the detected events to the time their samples were handed to the daq_interface.
+ */
+struct ReplayState {
+    unsigned int sample_rate = 6400;
+    timespec replay_start_time;
+
+    // first sample and monotonic time in nanoseconds of every batch, written before the batch is added
+    vector<pair<uint64_t, int64_t>> batches;
+    atomic<size_t> number_of_batches{0};
+
+    mutex latency_mutex;
+    vector<double> event_latencies;
+};
+
+static int64_t toNanoseconds(const timespec &time) {
+    return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+static timespec toTimespec(int64_t nanoseconds) {
+    timespec time;
+    time.tv_sec = nanoseconds / 1000000000;
+    time.tv_nsec = nanoseconds % 1000000000;
+    return time;
+}
+
+static int64_t monotonicNow() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return toNanoseconds(now);
+}
+
+static void onEvent(const timespec *event_time, size_t samples_from_event_time, void *user_data) {
+    ReplayState &state = *static_cast<ReplayState *>(user_data);
+    int64_t now = monotonicNow();
+
+    // the samples are stamped with their position in the recording, so the event time tells the sample of the event.
+    // The event is complete with the last of the samples stored from that sample on.
+    int64_t since_start = toNanoseconds(*event_time) - toNanoseconds(state.replay_start_time);
+    uint64_t event_sample = since_start < 0 ? 0 : static_cast<uint64_t>(since_start * 1e-9 * state.sample_rate);
+    uint64_t last_event_sample = event_sample + std::max<size_t>(samples_from_event_time, 1) - 1;
+    auto batches_end = state.batches.begin() + state.number_of_batches.load(memory_order_acquire);
+    auto batch = upper_bound(state.batches.begin(), batches_end, make_pair(last_event_sample, INT64_MAX));
+    if (batch == state.batches.begin()) {
+        return;
+    }
+    --batch;
+
+    lock_guard<mutex> lock(state.latency_mutex);
+    state.event_latencies.push_back((now - batch->second) * 1e-6);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        cout << "usage: medal_replay_setup <sample rate> <speed> <raw files>...\n";
+        cout << "Replays .bin captures of energy_daq through the daq_interface. A speed of 1 replays in real time, N "
+                "replays N times faster and 0 as fast as possible.\n";
+        return 0;
+    }
+
+    ReplayState state;
+    state.sample_rate = static_cast<unsigned int>(stoul(argv[1]));
+    double speed = stod(argv[2]);
+    vector<string> input_files(argv + 3, argv + argc);
+    // the captures are named after their start time and sequence number
+    sort(input_files.begin(), input_files.end());
+
+    const size_t batch_size = 1024;
+    vector<MappedFile> captures;
+    size_t maximal_number_of_batches = 0;
+    for (const auto &input_file: input_files) {
+        captures.emplace_back(input_file);
+        captures.back().adviseSequential();
+        maximal_number_of_batches += captures.back().size() / MEDALPacket::packet_length / batch_size + 1;
+    }
+    state.batches.resize(maximal_number_of_batches);
+
+    setMEDALEventCallback(&onEvent, &state);
+    init_daq_interface(state.sample_rate);
+
+    vector<float> samples(batch_size * MEDALPacket::number_of_channels);
+    uint64_t samples_replayed = 0;
+    unsigned long trigger_id_gaps = 0;
+    bool first_packet = true;
+    uint16_t previous_trigger_id = 0;
+    clock_gettime(CLOCK_MONOTONIC, &state.replay_start_time);
+    const int64_t start = toNanoseconds(state.replay_start_time);
+
+    for (size_t file = 0; file < captures.size(); ++file) {
+        const uint8_t *packets = reinterpret_cast<const uint8_t *>(captures[file].data());
+        size_t number_of_packets = captures[file].size() / MEDALPacket::packet_length;
+        if (captures[file].size() % MEDALPacket::packet_length != 0) {
+            cerr << "Last packet incomplete in file: " << input_files[file] << endl;
+        }
+
+        for (size_t first = 0; first < number_of_packets; first += batch_size) {
+            size_t packets_in_batch = min(batch_size, number_of_packets - first);
+            const uint8_t *batch = packets + first * MEDALPacket::packet_length;
+            for (size_t i = 0; i < packets_in_batch; ++i) {
+                uint16_t trigger_id = MEDALPacket::triggerId(batch + i * MEDALPacket::packet_length);
+                if (!first_packet && !MEDALPacket::isNextTriggerId(previous_trigger_id, trigger_id)) {
+                    ++trigger_id_gaps;
+                }
+                first_packet = false;
+                previous_trigger_id = trigger_id;
+            }
+            decodeMEDALPackets(batch, packets_in_batch, samples.data());
+
+            int64_t recording_offset = static_cast<int64_t>(samples_replayed * 1e9 / state.sample_rate);
+            if (speed > 0) {
+                // hand the batch over when its last sample would have been received
+                int64_t due = start + static_cast<int64_t>((samples_replayed + packets_in_batch) * 1e9 /
+                                                           state.sample_rate / speed);
+                this_thread::sleep_for(chrono::nanoseconds(due - monotonicNow()));
+            }
+
+            size_t batch_index = state.number_of_batches.load(memory_order_relaxed);
+            state.batches[batch_index] = make_pair(samples_replayed, monotonicNow());
+            state.number_of_batches.store(batch_index + 1, memory_order_release);
+
+            timespec first_sample_time = toTimespec(start + recording_offset);
+            addMEDALDataPoints(samples.data(), packets_in_batch, &first_sample_time);
+            samples_replayed += packets_in_batch;
+        }
+    }
+    int64_t replay_end = monotonicNow();
+    free_daq_interface();
+    int64_t detection_end = monotonicNow();
+
+    double replay_seconds = (replay_end - start) * 1e-9;
+    double total_seconds = (detection_end - start) * 1e-9;
+    cout << "replayed samples: " << samples_replayed << " (" << samples_replayed / static_cast<double>(state.sample_rate)
+         << " s of data)" << endl;
+    cout << "trigger id gaps: " << trigger_id_gaps << endl;
+    cout << "replay time: " << replay_seconds << " s, " << samples_replayed / replay_seconds << " samples/s" << endl;
+    cout << "replay and detection time: " << total_seconds << " s, " << samples_replayed / total_seconds
+         << " samples/s, " << samples_replayed / static_cast<double>(state.sample_rate) / total_seconds
+         << " x real time" << endl;
+
+    lock_guard<mutex> lock(state.latency_mutex);
+    vector<double> &latencies = state.event_latencies;
+    cout << "events: " << latencies.size() << endl;
+    if (!latencies.empty()) {
+        sort(latencies.begin(), latencies.end());
+        double sum = 0;
+        for (double latency: latencies) {
+            sum += latency;
+        }
+        cout << "event latency in ms (from handing over the last sample of the event to the event callback): mean "
+             << sum / latencies.size() << ", median " << latencies[latencies.size() / 2] << ", max "
+             << latencies.back() << endl;
+    }
+    return 0;
+}
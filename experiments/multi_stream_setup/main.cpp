@@ -0,0 +1,119 @@
+#include <iostream>
+
+#define DONT_STORE_ANYTHING
+
+#include <PowerMetaData.h>
+#include <DefaultDataPoint.h>
+#include <DefaultEventDetectionStrategy.h>
+#include <DetectionServer.h>
+#include <DataClassifier.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+typedef DetectionServer<DefaultEventDetectionStrategy, DefaultDataPoint> MultiStreamServer;
+
+// a load that is switched on and off every few seconds, so every stream has events
+static void fillBuffer(std::vector<DefaultDataPoint> &buffer, const PowerMetaData &conf, unsigned long seed) {
+    std::mt19937 mt(seed);
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+    std::uniform_int_distribution<unsigned long> switch_periods(conf.frequency * 2, conf.frequency * 6);
+    const float pi = 3.14159265358979f;
+    const unsigned long data_points_per_period = conf.dataPointsPerPeriod();
+
+    unsigned long next_switch = switch_periods(mt) * data_points_per_period;
+    bool load_on = false;
+    for (unsigned long i = 0; i < buffer.size(); ++i) {
+        if (i == next_switch) {
+            load_on = !load_on;
+            next_switch += switch_periods(mt) * data_points_per_period;
+        }
+        float phase = 2 * pi * static_cast<float>(i % data_points_per_period) / data_points_per_period;
+        float amplitude = load_on ? 5.0f : 0.5f;
+        buffer[i].amps = amplitude * std::sin(phase) + noise(mt);
+        buffer[i].volts = 170.0f * std::sin(phase);
+    }
+}
+
+// every producer feeds its streams one second at a time, like a host receiving the packets of many meters
+static void produce(MultiStreamServer *server, const std::vector<MultiStreamServer::StreamIdType> &stream_ids,
+                    const std::vector<std::vector<DefaultDataPoint>> *stream_data, unsigned long sample_rate) {
+    const unsigned long data_points = stream_data->front().size();
+    for (unsigned long offset = 0; offset < data_points; offset += sample_rate) {
+        const unsigned long end = std::min(offset + sample_rate, data_points);
+        for (auto stream_id: stream_ids) {
+            const auto &data = (*stream_data)[stream_id % stream_data->size()];
+            server->addDataPoints(stream_id, data.begin() + offset, data.begin() + end);
+        }
+    }
+    for (auto stream_id: stream_ids) {
+        server->endStream(stream_id);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        cout << "usage multi_stream_setup <config file> <number of streams> [<number of workers>] [<seconds per stream>]"
+             << endl;
+        return -1;
+    }
+
+    PowerMetaData conf;
+    if (!conf.load(argv[1])) {
+        std::cout << "Could not load config file: " << argv[1] << "\n";
+        return -1;
+    }
+    const unsigned long number_of_streams = std::max(atol(argv[2]), 1l);
+    const unsigned int number_of_workers = argc >= 4 ? static_cast<unsigned int>(atoi(argv[3])) : 0;
+    const unsigned long seconds_per_stream = argc >= 5 ? std::max(atol(argv[4]), 1l) : 60;
+    std::cout << conf << endl;
+
+    // the streams reuse a few different recordings, generating one per stream would take longer than the detection
+    const unsigned long number_of_recordings = std::min<unsigned long>(number_of_streams, 8);
+    std::vector<std::vector<DefaultDataPoint>> recordings(number_of_recordings);
+    for (unsigned long i = 0; i < number_of_recordings; ++i) {
+        recordings[i].resize(conf.sample_rate * seconds_per_stream);
+        fillBuffer(recordings[i], conf, i);
+    }
+
+    // one classifier for all meters, pushEvent may be called by all workers at once
+    DataClassifier<DefaultDataPoint> analyzer;
+    analyzer.startClassification();
+    DataClassifier<DefaultDataPoint> *analyzer_ptr = &analyzer;
+    std::atomic<unsigned long> number_of_events{0};
+
+    MultiStreamServer server(number_of_workers);
+    server.setEventCallback([analyzer_ptr, &number_of_events](MultiStreamServer::StreamIdType, Event<DefaultDataPoint> &e) {
+        analyzer_ptr->pushEvent(e);
+        ++number_of_events;
+    });
+
+    const unsigned long number_of_producers = std::min<unsigned long>(number_of_streams, 4);
+    std::vector<std::vector<MultiStreamServer::StreamIdType>> producer_streams(number_of_producers);
+    for (unsigned long i = 0; i < number_of_streams; ++i) {
+        producer_streams[i % number_of_producers].push_back(server.addStream(conf, DefaultEventDetectionStrategy(0.3f)));
+    }
+
+    auto start = chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (const auto &stream_ids: producer_streams) {
+        producers.emplace_back(produce, &server, std::cref(stream_ids), &recordings, conf.sample_rate);
+    }
+    for (auto &producer: producers) {
+        producer.join();
+    }
+    server.waitUntilDone();
+    auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    analyzer.stopAnalyzingWhenDone();
+
+    const double seconds = std::max(duration.count(), 1l) / 1000.0;
+    const double stream_seconds = static_cast<double>(number_of_streams * seconds_per_stream);
+    cout << "analyzed " << stream_seconds << " seconds of data of " << number_of_streams << " streams in " << seconds
+         << " seconds, " << number_of_events << " events" << endl;
+    cout << "real time factor: " << stream_seconds / seconds << " (" << stream_seconds / seconds / number_of_streams
+         << " per stream)" << endl;
+}
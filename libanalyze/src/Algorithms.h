@@ -8,15 +8,19 @@
 #include <vector>
 #include <algorithm>
 #include <exception>
+#include <cassert>
+#include <type_traits>
 #include <iostream>
 
 #include "Utilities.h"
+#include "SimdKernels.h"
 
 namespace Algorithms {
     template<typename IteratorType> auto
-    rootMeanSquare(IteratorType begin, const IteratorType end) -> decltype(*begin) {
-        decltype(*begin) result = 0.0;
-        decltype(*begin) n = end - begin;
+    rootMeanSquare(IteratorType begin, const IteratorType end) -> typename std::decay<decltype(*begin)>::type {
+        typedef typename std::decay<decltype(*begin)>::type ValueType;
+        ValueType result = 0.0;
+        ValueType n = end - begin;
         while (begin != end) {
             result += *begin * *begin;
             ++begin;
@@ -24,6 +28,32 @@ namespace Algorithms {
         return std::sqrt(result / n);
     }
 
+    /**
+     * @brief rootMeanSquare of contiguous values, like the columns of a SampleBlock, with the SimdKernels.
+     */
+    inline float rootMeanSquare(const float *begin, const float *end) {
+        const std::size_t n = static_cast<std::size_t>(end - begin);
+        return std::sqrt(SimdKernels::kernels().sum_of_squares(begin, n) / n);
+    }
+
+    // without these overloads a float * would match the iterator template better than const float * and miss the kernels
+    inline float rootMeanSquare(float *begin, float *end) {
+        return rootMeanSquare(static_cast<const float *>(begin), static_cast<const float *>(end));
+    }
+
+    /**
+     * @brief Writes the rootMeanSquare of number_of_periods consecutive periods of period_length values, starting at begin,
+     * to result. The kernels are looked up once for all periods.
+     */
+    inline void rootMeanSquareOfPeriods(const float *begin, unsigned long period_length, unsigned long number_of_periods,
+                                        float *result) {
+        const auto sum_of_squares = SimdKernels::kernels().sum_of_squares;
+        for (unsigned long period = 0; period < number_of_periods; ++period) {
+            result[period] = std::sqrt(sum_of_squares(begin, period_length) / period_length);
+            begin += period_length;
+        }
+    }
+
     template<typename IteratorType> auto
     rootMeanSquareOfAmpere(IteratorType begin, const IteratorType end) -> decltype(begin->ampere()) {
         return rootMeanSquare(makeAmpereIterator(begin), makeAmpereIterator(end));
@@ -43,6 +73,12 @@ namespace Algorithms {
         return std::sqrt(result / n);
     }
 
+    inline float euclideanDistance(const float *begin, const float *end, const float *begin2, const float *end2) {
+        const std::size_t n = static_cast<std::size_t>(end - begin);
+        const std::size_t common = std::min(n, static_cast<std::size_t>(end2 - begin2));
+        return std::sqrt(SimdKernels::kernels().sum_of_squared_differences(begin, begin2, common) / n);
+    }
+
     template<typename IteratorType, typename DataType = float> DataType
     mean(IteratorType begin, const IteratorType end) {
         DataType result = 0.0;
@@ -52,20 +88,54 @@ namespace Algorithms {
         return result / n;
     }
 
+    inline float mean(const float *begin, const float *end) {
+        const std::size_t n = static_cast<std::size_t>(end - begin);
+        return SimdKernels::kernels().sum(begin, n) / n;
+    }
+
+    inline float mean(float *begin, float *end) {
+        return mean(static_cast<const float *>(begin), static_cast<const float *>(end));
+    }
+
+    /**
+     * @brief Returns the sum of the squared deviations from the mean, not divided by the number of values. The values are
+     * only read once, the mean is updated with Welford's algorithm.
+     */
     template<typename IteratorType, typename DataType = float> DataType
     variance(IteratorType begin, const IteratorType end) {
         DataType result = 0.0;
-        DataType iter_mean = mean(begin, end);
-
+        DataType iter_mean = 0.0;
+        DataType count = 0.0;
 
         while (begin != end) {
-            DataType diff = *begin - iter_mean;
-            result += diff * diff;
+            DataType value = *begin;
+            ++count;
+            DataType diff = value - iter_mean;
+            iter_mean += diff / count;
+            result += diff * (value - iter_mean);
             ++begin;
         }
         return result;
     }
 
+    inline float variance(const float *begin, const float *end) {
+        float iter_mean;
+        float result;
+        SimdKernels::kernels().mean_and_squared_deviations(begin, static_cast<std::size_t>(end - begin), iter_mean, result);
+        return result;
+    }
+
+    inline float variance(float *begin, float *end) {
+        return variance(static_cast<const float *>(begin), static_cast<const float *>(end));
+    }
+
+    /**
+     * @brief Calculates the mean and the variance in the sense of variance, the sum of the squared deviations, in one pass.
+     */
+    inline void meanAndVariance(const float *begin, const float *end, float &mean, float &variance) {
+        SimdKernels::kernels().mean_and_squared_deviations(begin, static_cast<std::size_t>(end - begin), mean, variance);
+    }
+
     inline std::vector<float> getHarmonics(const std::vector<kiss_fft_cpx> &data_points, unsigned long base_frequency,
                                            unsigned long number_of_harmonics = 20, unsigned long search_radius = 5) {
         ++number_of_harmonics;
@@ -83,6 +153,43 @@ namespace Algorithms {
         return result;
     }
 
+    /**
+     * @brief Like getHarmonics, but on a sparse spectrum that only contains the search_radius * 2 bins around each harmonic,
+     * starting with the second harmonic.
+     */
+    inline std::vector<float> getHarmonicsOfNeighbourhoods(std::vector<kiss_fft_cpx>::const_iterator begin,
+                                                           unsigned long number_of_harmonics = 20,
+                                                           unsigned long search_radius = 5) {
+        std::vector<float> result;
+        const unsigned long neighbourhood_size = std::max(search_radius * 2, 1ul);
+
+        for (unsigned long i = 0; i < number_of_harmonics; ++i) {
+            float harm = std::abs(std::max_element(begin, begin + neighbourhood_size,
+                                                   [](const kiss_fft_cpx &cpx1, const kiss_fft_cpx &cpx2) {
+                                                       return std::abs(cpx1.r) < std::abs(cpx2.r);
+                                                   })->r);
+            result.push_back(harm);
+            begin += neighbourhood_size;
+        }
+        return result;
+    }
+
+    inline void blackmanHarrisWindow(std::vector<float> &window, const unsigned long N) {
+        window.resize(N);
+
+        const float a0      = 0.35875f;
+        const float a1      = 0.48829f;
+        const float a2      = 0.14128f;
+        const float a3      = 0.01168f;
+
+        unsigned int idx    = 0;
+        while( idx < N )
+        {
+            window[idx]   = a0 - (a1 * cosf( (2.0f * M_PI * idx) / (N - 1) )) + (a2 * cosf( (4.0f * M_PI * idx) / (N - 1) )) - (a3 * cosf( (6.0f * M_PI * idx) / (N - 1) ));
+            idx++;
+        }
+    }
+
 }
 
 #endif //SMART_SCREEN_ALGORITHMS_H
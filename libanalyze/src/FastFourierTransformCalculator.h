@@ -2,11 +2,24 @@
 #define SMART_SCREEN_FOURIERTRANSFORMCALCULATOR_H
 
 #include <kiss_fft.h>
+#include <kiss_fftr.h>
 #include <memory>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <cmath>
 #include "Utilities.h"
-
+#include "Algorithms.h"
+
+/**
+ * @brief Calculates FFTs with kiss_fft.
+ *
+ * The plans (twiddle factors) are cached per transform size, so repeated transforms of the same size only pay for the transform
+ * itself. The calculate*FFT methods return the full complex spectrum of N points. The calculate*RealFFT methods use the
+ * real input transform of kiss_fftr and only return the N / 2 + 1 non redundant points of the spectrum, which is about half
+ * the work. All methods have an overload that writes into a caller provided buffer, so no memory is allocated once the buffers
+ * have reached their size.
+ */
 class FastFourierTransformCalculator {
 public:
     typedef float DataPointType;
@@ -22,8 +35,8 @@ public:
     void setMaxDataSetSize(unsigned long _max_data_size) {
         max_data_size = _max_data_size;
         kiss_fft_buffer.resize(max_data_size);
-        size_t lenmem = 1024 + (_max_data_size) * sizeof(kiss_fft_cpx);
-        cfg_buffer.resize(lenmem);
+        kiss_fft_output_buffer.resize(max_data_size);
+        real_fft_buffer.resize(max_data_size);
     }
 
 
@@ -31,24 +44,57 @@ public:
 
     template<typename IteratorType> std::vector<kiss_fft_cpx> calculateVoltageFFT(IteratorType begin, IteratorType end);
     template<typename IteratorType> std::vector<kiss_fft_cpx> calculateFFT(IteratorType begin, IteratorType end);
+    template<typename IteratorType> void
+    calculateFFT(IteratorType begin, IteratorType end, std::vector<kiss_fft_cpx> &result);
 
     template<typename IteratorType> std::vector<kiss_fft_cpx> calculateAmpereFFTWithBlackmanHarris(IteratorType begin, IteratorType end);
     template<typename IteratorType> std::vector<kiss_fft_cpx> calculateVoltageFFTWithBlackmanHarris(IteratorType begin, IteratorType end);
 
     template<typename IteratorType> std::vector<kiss_fft_cpx> calculateFFTWithBlackmanHarris(IteratorType begin, IteratorType end);
+    template<typename IteratorType> void
+    calculateFFTWithBlackmanHarris(IteratorType begin, IteratorType end, std::vector<kiss_fft_cpx> &result);
+
+    /**
+     * @brief Calculates the N / 2 + 1 non redundant points of the spectrum of the N real values in [begin, end) into result.
+     */
+    template<typename IteratorType> void
+    calculateRealFFT(IteratorType begin, IteratorType end, std::vector<kiss_fft_cpx> &result);
+
+    template<typename IteratorType> void
+    calculateAmpereRealFFTWithBlackmanHarris(IteratorType begin, IteratorType end, std::vector<kiss_fft_cpx> &result);
+
+    template<typename IteratorType> void
+    calculateVoltageRealFFTWithBlackmanHarris(IteratorType begin, IteratorType end, std::vector<kiss_fft_cpx> &result);
+
+    /**
+     * @brief Like calculateRealFFT, but the values are multiplied with a Blackman-Harris window first.
+     */
+    template<typename IteratorType> void
+    calculateRealFFTWithBlackmanHarris(IteratorType begin, IteratorType end, std::vector<kiss_fft_cpx> &result);
 
 
     kiss_fft_cfg initKissFFT(const unsigned long N);
+    kiss_fftr_cfg initKissFFTR(const unsigned long N);
     template<typename IteratorType> void fillKissFFTBuffer(IteratorType begin, IteratorType end);
+    template<typename IteratorType> void fillRealFFTBuffer(IteratorType begin, IteratorType end);
     void multiplyKissFFTBufferWithBMH(const unsigned long N);
+    void multiplyRealFFTBufferWithBMH(const unsigned long N);
     const std::vector<DataPointType>& getBlackmanHarrisBuffer(const unsigned long N);
 
     std::vector<kiss_fft_cpx> kiss_fft_buffer;
+    std::vector<kiss_fft_cpx> kiss_fft_output_buffer;
+    std::vector<kiss_fft_scalar> real_fft_buffer;
     std::vector<DataPointType> blackman_harris_buffer;
 
 
     unsigned long max_data_size = 0;
-    std::vector<char> cfg_buffer;
+
+    // memory of the kiss_fft and kiss_fftr plans, by number of points
+    std::map<unsigned long, std::vector<char>> fft_plans;
+    std::map<unsigned long, std::vector<char>> real_fft_plans;
+
+private:
+    void runRealFFT(const unsigned long N, std::vector<kiss_fft_cpx> &result);
 };
 
 template<typename IteratorType> std::vector<kiss_fft_cpx>
@@ -63,13 +109,19 @@ FastFourierTransformCalculator::calculateVoltageFFT(IteratorType begin, Iterator
 
 template<typename IteratorType> std::vector<kiss_fft_cpx>
 FastFourierTransformCalculator::calculateFFT(IteratorType begin, IteratorType end) {
+    std::vector<kiss_fft_cpx> kiss_fft_result;
+    calculateFFT(begin, end, kiss_fft_result);
+    return kiss_fft_result;
+}
+
+template<typename IteratorType> void
+FastFourierTransformCalculator::calculateFFT(IteratorType begin, IteratorType end, std::vector<kiss_fft_cpx> &result) {
     unsigned long points_to_compute = end - begin;
     auto cfg = initKissFFT(points_to_compute);
     fillKissFFTBuffer(begin,end);
-    std::vector<kiss_fft_cpx> kiss_fft_result(points_to_compute);
+    result.resize(points_to_compute);
 
-    kiss_fft(cfg, kiss_fft_buffer.data(), kiss_fft_result.data());
-    return kiss_fft_result;
+    kiss_fft(cfg, kiss_fft_buffer.data(), result.data());
 }
 
 const std::vector<FastFourierTransformCalculator::DataPointType> &
@@ -77,32 +129,66 @@ FastFourierTransformCalculator::getBlackmanHarrisBuffer(const unsigned long N) {
     if(blackman_harris_buffer.size() == N ) {
         return this->blackman_harris_buffer;
     }
-    this->blackman_harris_buffer.resize(N);
-
-    const float a0      = 0.35875f;
-    const float a1      = 0.48829f;
-    const float a2      = 0.14128f;
-    const float a3      = 0.01168f;
-
-    unsigned int idx    = 0;
-    while( idx < N )
-    {
-        blackman_harris_buffer[idx]   = a0 - (a1 * cosf( (2.0f * M_PI * idx) / (N - 1) )) + (a2 * cosf( (4.0f * M_PI * idx) / (N - 1) )) - (a3 * cosf( (6.0f * M_PI * idx) / (N - 1) ));
-        idx++;
-    }
+    Algorithms::blackmanHarrisWindow(this->blackman_harris_buffer, N);
     return this->blackman_harris_buffer;
 }
 
 template<typename IteratorType> std::vector<kiss_fft_cpx>
 FastFourierTransformCalculator::calculateFFTWithBlackmanHarris(IteratorType begin, IteratorType end) {
+    std::vector<kiss_fft_cpx> kiss_fft_result;
+    calculateFFTWithBlackmanHarris(begin, end, kiss_fft_result);
+    return kiss_fft_result;
+}
+
+template<typename IteratorType> void
+FastFourierTransformCalculator::calculateFFTWithBlackmanHarris(IteratorType begin, IteratorType end,
+                                                               std::vector<kiss_fft_cpx> &result) {
     unsigned long points_to_compute = end - begin;
     auto cfg = initKissFFT(points_to_compute);
     fillKissFFTBuffer(begin,end);
-    std::vector<kiss_fft_cpx> kiss_fft_result(points_to_compute);
+    result.resize(points_to_compute);
     multiplyKissFFTBufferWithBMH(points_to_compute);
 
-    kiss_fft(cfg, kiss_fft_buffer.data(), kiss_fft_result.data());
-    return kiss_fft_result;
+    kiss_fft(cfg, kiss_fft_buffer.data(), result.data());
+}
+
+template<typename IteratorType> void
+FastFourierTransformCalculator::calculateRealFFT(IteratorType begin, IteratorType end, std::vector<kiss_fft_cpx> &result) {
+    unsigned long points_to_compute = end - begin;
+    if (points_to_compute > max_data_size) {
+        this->setMaxDataSetSize(points_to_compute);
+    }
+    fillRealFFTBuffer(begin, end);
+    runRealFFT(points_to_compute, result);
+}
+
+template<typename IteratorType> void
+FastFourierTransformCalculator::calculateRealFFTWithBlackmanHarris(IteratorType begin, IteratorType end,
+                                                                   std::vector<kiss_fft_cpx> &result) {
+    unsigned long points_to_compute = end - begin;
+    if (points_to_compute > max_data_size) {
+        this->setMaxDataSetSize(points_to_compute);
+    }
+    fillRealFFTBuffer(begin, end);
+    multiplyRealFFTBufferWithBMH(points_to_compute);
+    runRealFFT(points_to_compute, result);
+}
+
+inline void FastFourierTransformCalculator::runRealFFT(const unsigned long N, std::vector<kiss_fft_cpx> &result) {
+    result.resize(N / 2 + 1);
+    if (N % 2 == 0) {
+        kiss_fftr(initKissFFTR(N), real_fft_buffer.data(), result.data());
+        return;
+    }
+
+    // kiss_fftr only handles an even number of points, fall back to the complex transform
+    auto cfg = initKissFFT(N);
+    for (unsigned long i = 0; i < N; ++i) {
+        kiss_fft_buffer[i].r = real_fft_buffer[i];
+        kiss_fft_buffer[i].i = 0;
+    }
+    kiss_fft(cfg, kiss_fft_buffer.data(), kiss_fft_output_buffer.data());
+    std::copy(kiss_fft_output_buffer.begin(), kiss_fft_output_buffer.begin() + result.size(), result.begin());
 }
 
 kiss_fft_cfg FastFourierTransformCalculator::initKissFFT(const unsigned long N) {
@@ -110,10 +196,25 @@ kiss_fft_cfg FastFourierTransformCalculator::initKissFFT(const unsigned long N)
         this->setMaxDataSetSize(N);
     }
 
+    std::vector<char> &plan = this->fft_plans[N];
+    size_t lenmem = plan.size();
+    if (plan.empty()) {
+        kiss_fft_alloc(static_cast<int>(N), 0, nullptr, &lenmem);
+        plan.resize(lenmem);
+        return kiss_fft_alloc(static_cast<int>(N), 0, reinterpret_cast<void *>(plan.data()), &lenmem);
+    }
+    return reinterpret_cast<kiss_fft_cfg>(plan.data());
+}
 
-    size_t lenmem = this->cfg_buffer.size();
-    return kiss_fft_alloc(static_cast<int>(N), 0,
-                                      reinterpret_cast<void *>(cfg_buffer.data()), &lenmem);
+inline kiss_fftr_cfg FastFourierTransformCalculator::initKissFFTR(const unsigned long N) {
+    std::vector<char> &plan = this->real_fft_plans[N];
+    size_t lenmem = plan.size();
+    if (plan.empty()) {
+        kiss_fftr_alloc(static_cast<int>(N), 0, nullptr, &lenmem);
+        plan.resize(lenmem);
+        return kiss_fftr_alloc(static_cast<int>(N), 0, reinterpret_cast<void *>(plan.data()), &lenmem);
+    }
+    return reinterpret_cast<kiss_fftr_cfg>(plan.data());
 }
 
 template<typename IteratorType> void
@@ -127,11 +228,27 @@ FastFourierTransformCalculator::fillKissFFTBuffer(IteratorType begin, IteratorTy
     }
 }
 
+template<typename IteratorType> void
+FastFourierTransformCalculator::fillRealFFTBuffer(IteratorType begin, IteratorType end) {
+    auto buffer_iter = real_fft_buffer.begin();
+    while (begin != end && buffer_iter != real_fft_buffer.end()) {
+        *buffer_iter = *begin;
+        ++begin;
+        ++buffer_iter;
+    }
+}
+
 void FastFourierTransformCalculator::multiplyKissFFTBufferWithBMH(const unsigned long N) {
-    auto bmh_iter = this->getBlackmanHarrisBuffer(N).begin();
-    for(auto& cpx: kiss_fft_buffer) {
-        cpx.r = *bmh_iter * cpx.r;
-        ++bmh_iter;
+    const auto &bmh = this->getBlackmanHarrisBuffer(N);
+    for (unsigned long i = 0; i < N; ++i) {
+        kiss_fft_buffer[i].r *= bmh[i];
+    }
+}
+
+inline void FastFourierTransformCalculator::multiplyRealFFTBufferWithBMH(const unsigned long N) {
+    const auto &bmh = this->getBlackmanHarrisBuffer(N);
+    for (unsigned long i = 0; i < N; ++i) {
+        real_fft_buffer[i] *= bmh[i];
     }
 }
 
@@ -145,4 +262,16 @@ FastFourierTransformCalculator::calculateVoltageFFTWithBlackmanHarris(IteratorTy
     return calculateFFTWithBlackmanHarris(makeVoltageIterator(begin), makeVoltageIterator(end));
 }
 
+template<typename IteratorType> void
+FastFourierTransformCalculator::calculateAmpereRealFFTWithBlackmanHarris(IteratorType begin, IteratorType end,
+                                                                         std::vector<kiss_fft_cpx> &result) {
+    calculateRealFFTWithBlackmanHarris(makeAmpereIterator(begin), makeAmpereIterator(end), result);
+}
+
+template<typename IteratorType> void
+FastFourierTransformCalculator::calculateVoltageRealFFTWithBlackmanHarris(IteratorType begin, IteratorType end,
+                                                                          std::vector<kiss_fft_cpx> &result) {
+    calculateRealFFTWithBlackmanHarris(makeVoltageIterator(begin), makeVoltageIterator(end), result);
+}
+
 #endif //SMART_SCREEN_FOURIERTRANSFORMCALCULATOR_H
@@ -0,0 +1,371 @@
+#ifndef SMART_SCREEN_SIMDKERNELS_H
+#define SMART_SCREEN_SIMDKERNELS_H
+
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SMART_SCREEN_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace InstructionSet {
+    enum InstructionSet {
+        Scalar, /**< Plain C++, used on every platform without an explicit implementation. */
+        SSE2,
+        AVX2,
+        AVX512 /**< AVX-512F */
+    };
+}
+
+/**
+ * @brief Reductions over contiguous float ranges, like the columns of a SampleBlock, with explicit SSE2, AVX2 and AVX-512
+ * implementations.
+ *
+ * All implementations are compiled into every binary with target attributes, kernels() picks the widest one the CPU supports
+ * when it is first called. The sums are accumulated in several vector registers and reduced at the end, so the results
+ * differ from a sequential float sum in the last bits. meanAndSquaredDeviations runs Welford's algorithm in every lane and
+ * merges the lanes with the pairwise update of Chan et al., it needs a single pass and does not cancel like the sum of
+ * squares minus the squared sum.
+ */
+namespace SimdKernels {
+
+    struct KernelTable {
+        InstructionSet::InstructionSet instruction_set;
+
+        float (*sum)(const float *values, std::size_t n);
+
+        float (*sum_of_squares)(const float *values, std::size_t n);
+
+        float (*sum_of_squared_differences)(const float *values, const float *other_values, std::size_t n);
+
+        /**
+         * @brief Calculates the mean and the sum of the squared deviations from the mean.
+         */
+        void (*mean_and_squared_deviations)(const float *values, std::size_t n, float &mean, float &squared_deviations);
+    };
+
+    namespace detail {
+        inline float sumLanes(const float *lanes, unsigned int number_of_lanes) {
+            float result = 0;
+            for (unsigned int lane = 0; lane < number_of_lanes; ++lane) {
+                result += lanes[lane];
+            }
+            return result;
+        }
+
+        /**
+         * @brief Merges number_of_lanes Welford states of lane_count values each and adds the remaining values one by one.
+         */
+        inline void finishWelford(const float *lane_means, const float *lane_squared_deviations, unsigned int number_of_lanes,
+                                  std::size_t lane_count, const float *values, std::size_t n, float &mean,
+                                  float &squared_deviations) {
+            double merged_mean = 0;
+            double merged_squared_deviations = 0;
+            std::size_t count = 0;
+            if (lane_count > 0) {
+                for (unsigned int lane = 0; lane < number_of_lanes; ++lane) {
+                    merged_mean += lane_means[lane];
+                }
+                merged_mean /= number_of_lanes;
+                for (unsigned int lane = 0; lane < number_of_lanes; ++lane) {
+                    double delta = lane_means[lane] - merged_mean;
+                    merged_squared_deviations += lane_squared_deviations[lane] + lane_count * delta * delta;
+                }
+                count = lane_count * number_of_lanes;
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                ++count;
+                double delta = values[i] - merged_mean;
+                merged_mean += delta / count;
+                merged_squared_deviations += delta * (values[i] - merged_mean);
+            }
+            mean = static_cast<float>(merged_mean);
+            squared_deviations = static_cast<float>(merged_squared_deviations);
+        }
+    }
+
+    inline float sumScalar(const float *values, std::size_t n) {
+        float result = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            result += values[i];
+        }
+        return result;
+    }
+
+    inline float sumOfSquaresScalar(const float *values, std::size_t n) {
+        float result = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            result += values[i] * values[i];
+        }
+        return result;
+    }
+
+    inline float sumOfSquaredDifferencesScalar(const float *values, const float *other_values, std::size_t n) {
+        float result = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            float difference = values[i] - other_values[i];
+            result += difference * difference;
+        }
+        return result;
+    }
+
+    inline void meanAndSquaredDeviationsScalar(const float *values, std::size_t n, float &mean, float &squared_deviations) {
+        detail::finishWelford(nullptr, nullptr, 0, 0, values, n, mean, squared_deviations);
+    }
+
+#ifdef SMART_SCREEN_X86_KERNELS
+
+    __attribute__((target("sse2"))) inline float sumSse2(const float *values, std::size_t n) {
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            sum0 = _mm_add_ps(sum0, _mm_loadu_ps(values + i));
+            sum1 = _mm_add_ps(sum1, _mm_loadu_ps(values + i + 4));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+        return detail::sumLanes(lanes, 4) + sumScalar(values + i, n - i);
+    }
+
+    __attribute__((target("sse2"))) inline float sumOfSquaresSse2(const float *values, std::size_t n) {
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128 value0 = _mm_loadu_ps(values + i);
+            __m128 value1 = _mm_loadu_ps(values + i + 4);
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(value0, value0));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(value1, value1));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+        return detail::sumLanes(lanes, 4) + sumOfSquaresScalar(values + i, n - i);
+    }
+
+    __attribute__((target("sse2"))) inline float
+    sumOfSquaredDifferencesSse2(const float *values, const float *other_values, std::size_t n) {
+        __m128 sum = _mm_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 difference = _mm_sub_ps(_mm_loadu_ps(values + i), _mm_loadu_ps(other_values + i));
+            sum = _mm_add_ps(sum, _mm_mul_ps(difference, difference));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, sum);
+        return detail::sumLanes(lanes, 4) + sumOfSquaredDifferencesScalar(values + i, other_values + i, n - i);
+    }
+
+    __attribute__((target("sse2"))) inline void
+    meanAndSquaredDeviationsSse2(const float *values, std::size_t n, float &mean, float &squared_deviations) {
+        __m128 lane_mean = _mm_setzero_ps();
+        __m128 lane_squared_deviations = _mm_setzero_ps();
+        std::size_t lane_count = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            ++lane_count;
+            __m128 value = _mm_loadu_ps(values + i);
+            __m128 delta = _mm_sub_ps(value, lane_mean);
+            lane_mean = _mm_add_ps(lane_mean, _mm_mul_ps(delta, _mm_set1_ps(1.0f / lane_count)));
+            lane_squared_deviations = _mm_add_ps(lane_squared_deviations,
+                                                 _mm_mul_ps(delta, _mm_sub_ps(value, lane_mean)));
+        }
+        float means[4];
+        float deviations[4];
+        _mm_storeu_ps(means, lane_mean);
+        _mm_storeu_ps(deviations, lane_squared_deviations);
+        detail::finishWelford(means, deviations, 4, lane_count, values + i, n - i, mean, squared_deviations);
+    }
+
+    __attribute__((target("avx2"))) inline float sumAvx2(const float *values, std::size_t n) {
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            sum0 = _mm256_add_ps(sum0, _mm256_loadu_ps(values + i));
+            sum1 = _mm256_add_ps(sum1, _mm256_loadu_ps(values + i + 8));
+        }
+        float lanes[8];
+        _mm256_storeu_ps(lanes, _mm256_add_ps(sum0, sum1));
+        return detail::sumLanes(lanes, 8) + sumScalar(values + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) inline float sumOfSquaresAvx2(const float *values, std::size_t n) {
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m256 value0 = _mm256_loadu_ps(values + i);
+            __m256 value1 = _mm256_loadu_ps(values + i + 8);
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(value0, value0));
+            sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(value1, value1));
+        }
+        float lanes[8];
+        _mm256_storeu_ps(lanes, _mm256_add_ps(sum0, sum1));
+        return detail::sumLanes(lanes, 8) + sumOfSquaresScalar(values + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) inline float
+    sumOfSquaredDifferencesAvx2(const float *values, const float *other_values, std::size_t n) {
+        __m256 sum = _mm256_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 difference = _mm256_sub_ps(_mm256_loadu_ps(values + i), _mm256_loadu_ps(other_values + i));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(difference, difference));
+        }
+        float lanes[8];
+        _mm256_storeu_ps(lanes, sum);
+        return detail::sumLanes(lanes, 8) + sumOfSquaredDifferencesScalar(values + i, other_values + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) inline void
+    meanAndSquaredDeviationsAvx2(const float *values, std::size_t n, float &mean, float &squared_deviations) {
+        __m256 lane_mean = _mm256_setzero_ps();
+        __m256 lane_squared_deviations = _mm256_setzero_ps();
+        std::size_t lane_count = 0;
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            ++lane_count;
+            __m256 value = _mm256_loadu_ps(values + i);
+            __m256 delta = _mm256_sub_ps(value, lane_mean);
+            lane_mean = _mm256_add_ps(lane_mean, _mm256_mul_ps(delta, _mm256_set1_ps(1.0f / lane_count)));
+            lane_squared_deviations = _mm256_add_ps(lane_squared_deviations,
+                                                    _mm256_mul_ps(delta, _mm256_sub_ps(value, lane_mean)));
+        }
+        float means[8];
+        float deviations[8];
+        _mm256_storeu_ps(means, lane_mean);
+        _mm256_storeu_ps(deviations, lane_squared_deviations);
+        detail::finishWelford(means, deviations, 8, lane_count, values + i, n - i, mean, squared_deviations);
+    }
+
+    __attribute__((target("avx512f"))) inline float sumAvx512(const float *values, std::size_t n) {
+        __m512 sum0 = _mm512_setzero_ps();
+        __m512 sum1 = _mm512_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            sum0 = _mm512_add_ps(sum0, _mm512_loadu_ps(values + i));
+            sum1 = _mm512_add_ps(sum1, _mm512_loadu_ps(values + i + 16));
+        }
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, _mm512_add_ps(sum0, sum1));
+        return detail::sumLanes(lanes, 16) + sumScalar(values + i, n - i);
+    }
+
+    __attribute__((target("avx512f"))) inline float sumOfSquaresAvx512(const float *values, std::size_t n) {
+        __m512 sum0 = _mm512_setzero_ps();
+        __m512 sum1 = _mm512_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m512 value0 = _mm512_loadu_ps(values + i);
+            __m512 value1 = _mm512_loadu_ps(values + i + 16);
+            sum0 = _mm512_add_ps(sum0, _mm512_mul_ps(value0, value0));
+            sum1 = _mm512_add_ps(sum1, _mm512_mul_ps(value1, value1));
+        }
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, _mm512_add_ps(sum0, sum1));
+        return detail::sumLanes(lanes, 16) + sumOfSquaresScalar(values + i, n - i);
+    }
+
+    __attribute__((target("avx512f"))) inline float
+    sumOfSquaredDifferencesAvx512(const float *values, const float *other_values, std::size_t n) {
+        __m512 sum = _mm512_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m512 difference = _mm512_sub_ps(_mm512_loadu_ps(values + i), _mm512_loadu_ps(other_values + i));
+            sum = _mm512_add_ps(sum, _mm512_mul_ps(difference, difference));
+        }
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, sum);
+        return detail::sumLanes(lanes, 16) + sumOfSquaredDifferencesScalar(values + i, other_values + i, n - i);
+    }
+
+    __attribute__((target("avx512f"))) inline void
+    meanAndSquaredDeviationsAvx512(const float *values, std::size_t n, float &mean, float &squared_deviations) {
+        __m512 lane_mean = _mm512_setzero_ps();
+        __m512 lane_squared_deviations = _mm512_setzero_ps();
+        std::size_t lane_count = 0;
+        std::size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            ++lane_count;
+            __m512 value = _mm512_loadu_ps(values + i);
+            __m512 delta = _mm512_sub_ps(value, lane_mean);
+            lane_mean = _mm512_add_ps(lane_mean, _mm512_mul_ps(delta, _mm512_set1_ps(1.0f / lane_count)));
+            lane_squared_deviations = _mm512_add_ps(lane_squared_deviations,
+                                                    _mm512_mul_ps(delta, _mm512_sub_ps(value, lane_mean)));
+        }
+        float means[16];
+        float deviations[16];
+        _mm512_storeu_ps(means, lane_mean);
+        _mm512_storeu_ps(deviations, lane_squared_deviations);
+        detail::finishWelford(means, deviations, 16, lane_count, values + i, n - i, mean, squared_deviations);
+    }
+
+#endif
+
+    /**
+     * @brief Returns true if the CPU can run the kernels of instruction_set.
+     */
+    inline bool isSupported(InstructionSet::InstructionSet instruction_set) {
+#ifdef SMART_SCREEN_X86_KERNELS
+        __builtin_cpu_init();
+        switch (instruction_set) {
+            case InstructionSet::Scalar:
+                return true;
+            case InstructionSet::SSE2:
+                return __builtin_cpu_supports("sse2");
+            case InstructionSet::AVX2:
+                return __builtin_cpu_supports("avx2");
+            case InstructionSet::AVX512:
+                return __builtin_cpu_supports("avx512f");
+            default:
+                return false;
+        }
+#else
+        return instruction_set == InstructionSet::Scalar;
+#endif
+    }
+
+    /**
+     * @brief Returns the kernels of instruction_set, or the scalar ones if they are not compiled in. The caller has to
+     * check isSupported first.
+     */
+    inline KernelTable kernelsFor(InstructionSet::InstructionSet instruction_set) {
+#ifdef SMART_SCREEN_X86_KERNELS
+        switch (instruction_set) {
+            case InstructionSet::AVX512:
+                return KernelTable{InstructionSet::AVX512, &sumAvx512, &sumOfSquaresAvx512, &sumOfSquaredDifferencesAvx512,
+                                   &meanAndSquaredDeviationsAvx512};
+            case InstructionSet::AVX2:
+                return KernelTable{InstructionSet::AVX2, &sumAvx2, &sumOfSquaresAvx2, &sumOfSquaredDifferencesAvx2,
+                                   &meanAndSquaredDeviationsAvx2};
+            case InstructionSet::SSE2:
+                return KernelTable{InstructionSet::SSE2, &sumSse2, &sumOfSquaresSse2, &sumOfSquaredDifferencesSse2,
+                                   &meanAndSquaredDeviationsSse2};
+            default:
+                break;
+        }
+#endif
+        return KernelTable{InstructionSet::Scalar, &sumScalar, &sumOfSquaresScalar, &sumOfSquaredDifferencesScalar,
+                           &meanAndSquaredDeviationsScalar};
+    }
+
+    /**
+     * @brief Returns the kernels of the widest instruction set the CPU supports. They are selected on the first call.
+     */
+    inline const KernelTable &kernels() {
+        static const KernelTable table = []() {
+            const InstructionSet::InstructionSet preferred[] = {InstructionSet::AVX512, InstructionSet::AVX2,
+                                                               InstructionSet::SSE2};
+            for (auto instruction_set: preferred) {
+                if (isSupported(instruction_set)) {
+                    return kernelsFor(instruction_set);
+                }
+            }
+            return kernelsFor(InstructionSet::Scalar);
+        }();
+        return table;
+    }
+}
+
+#endif //SMART_SCREEN_SIMDKERNELS_H
@@ -0,0 +1,146 @@
+#ifndef SMART_SCREEN_SPARSEFOURIERTRANSFORMCALCULATOR_H
+#define SMART_SCREEN_SPARSEFOURIERTRANSFORMCALCULATOR_H
+
+#include <kiss_fft.h>
+#include <vector>
+#include <cmath>
+#include "Utilities.h"
+#include "Algorithms.h"
+
+/**
+ * @brief Calculates single bins of the discrete fourier transform with the Goertzel algorithm.
+ *
+ * The result for bin k is the same as element k of the spectrum of the FastFourierTransformCalculator, but each bin costs O(N).
+ * This is cheaper than a full FFT when only a few bins, like the base frequency, are needed. The bins are evaluated in groups that
+ * share one pass over the data.
+ */
+class SparseFourierTransformCalculator {
+public:
+    typedef float DataPointType;
+
+    template<typename IteratorType> void
+    calculateBins(IteratorType begin, IteratorType end, const std::vector<unsigned long> &bins,
+                  std::vector<kiss_fft_cpx> &result);
+
+    template<typename IteratorType> void
+    calculateAmpereBinsWithBlackmanHarris(IteratorType begin, IteratorType end, const std::vector<unsigned long> &bins,
+                                          std::vector<kiss_fft_cpx> &result);
+
+    template<typename IteratorType> void
+    calculateVoltageBinsWithBlackmanHarris(IteratorType begin, IteratorType end, const std::vector<unsigned long> &bins,
+                                           std::vector<kiss_fft_cpx> &result);
+
+    template<typename IteratorType> void
+    calculateBinsWithBlackmanHarris(IteratorType begin, IteratorType end, const std::vector<unsigned long> &bins,
+                                    std::vector<kiss_fft_cpx> &result);
+
+private:
+    template<typename IteratorType> void fillBuffer(IteratorType begin, IteratorType end);
+
+    void runGoertzel(const std::vector<unsigned long> &bins, std::vector<kiss_fft_cpx> &result);
+
+private:
+    enum {
+        bins_per_pass = 4
+    };
+
+    std::vector<DataPointType> buffer;
+    std::vector<DataPointType> blackman_harris_buffer;
+};
+
+template<typename IteratorType> void
+SparseFourierTransformCalculator::calculateBins(IteratorType begin, IteratorType end,
+                                                const std::vector<unsigned long> &bins,
+                                                std::vector<kiss_fft_cpx> &result) {
+    fillBuffer(begin, end);
+    runGoertzel(bins, result);
+}
+
+template<typename IteratorType> void
+SparseFourierTransformCalculator::calculateBinsWithBlackmanHarris(IteratorType begin, IteratorType end,
+                                                                  const std::vector<unsigned long> &bins,
+                                                                  std::vector<kiss_fft_cpx> &result) {
+    fillBuffer(begin, end);
+    if (this->blackman_harris_buffer.size() != this->buffer.size()) {
+        Algorithms::blackmanHarrisWindow(this->blackman_harris_buffer, this->buffer.size());
+    }
+    for (unsigned long i = 0; i < this->buffer.size(); ++i) {
+        this->buffer[i] *= this->blackman_harris_buffer[i];
+    }
+    runGoertzel(bins, result);
+}
+
+template<typename IteratorType> void
+SparseFourierTransformCalculator::calculateAmpereBinsWithBlackmanHarris(IteratorType begin, IteratorType end,
+                                                                        const std::vector<unsigned long> &bins,
+                                                                        std::vector<kiss_fft_cpx> &result) {
+    calculateBinsWithBlackmanHarris(makeAmpereIterator(begin), makeAmpereIterator(end), bins, result);
+}
+
+template<typename IteratorType> void
+SparseFourierTransformCalculator::calculateVoltageBinsWithBlackmanHarris(IteratorType begin, IteratorType end,
+                                                                         const std::vector<unsigned long> &bins,
+                                                                         std::vector<kiss_fft_cpx> &result) {
+    calculateBinsWithBlackmanHarris(makeVoltageIterator(begin), makeVoltageIterator(end), bins, result);
+}
+
+template<typename IteratorType> void
+SparseFourierTransformCalculator::fillBuffer(IteratorType begin, IteratorType end) {
+    this->buffer.resize(end - begin);
+    auto buffer_iter = this->buffer.begin();
+    while (begin != end) {
+        *buffer_iter = *begin;
+        ++begin;
+        ++buffer_iter;
+    }
+}
+
+inline void
+SparseFourierTransformCalculator::runGoertzel(const std::vector<unsigned long> &bins, std::vector<kiss_fft_cpx> &result) {
+    const unsigned long N = this->buffer.size();
+    result.resize(bins.size());
+
+    for (unsigned long first_bin = 0; first_bin < bins.size(); first_bin += bins_per_pass) {
+        const unsigned long bins_in_pass = std::min<unsigned long>(bins_per_pass, bins.size() - first_bin);
+
+        double cosine[bins_per_pass] = {};
+        double sine[bins_per_pass] = {};
+        double coefficient[bins_per_pass] = {};
+        double s1[bins_per_pass] = {};
+        double s2[bins_per_pass] = {};
+        for (unsigned long b = 0; b < bins_in_pass; ++b) {
+            double omega = 2.0 * M_PI * bins[first_bin + b] / N;
+            cosine[b] = std::cos(omega);
+            sine[b] = std::sin(omega);
+            coefficient[b] = 2.0 * cosine[b];
+        }
+
+        if (bins_in_pass == bins_per_pass) {
+            // the constant trip count lets the compiler keep the recurrences in registers
+            for (const DataPointType value: this->buffer) {
+                for (unsigned long b = 0; b < bins_per_pass; ++b) {
+                    double s0 = value + coefficient[b] * s1[b] - s2[b];
+                    s2[b] = s1[b];
+                    s1[b] = s0;
+                }
+            }
+        } else {
+            // the remaining bins of the last pass, there are no padding bins to compute
+            for (const DataPointType value: this->buffer) {
+                for (unsigned long b = 0; b < bins_in_pass; ++b) {
+                    double s0 = value + coefficient[b] * s1[b] - s2[b];
+                    s2[b] = s1[b];
+                    s1[b] = s0;
+                }
+            }
+        }
+
+        // one more step with a zero input turns the filter state into the DFT value
+        for (unsigned long b = 0; b < bins_in_pass; ++b) {
+            result[first_bin + b].r = static_cast<float>(s1[b] * cosine[b] - s2[b]);
+            result[first_bin + b].i = static_cast<float>(s1[b] * sine[b]);
+        }
+    }
+}
+
+#endif //SMART_SCREEN_SPARSEFOURIERTRANSFORMCALCULATOR_H
@@ -0,0 +1,204 @@
+#include "MEDALHdf5Converter.h"
+#include "MappedFile.h"
+
+#include <regex>
+#include <thread>
+#include <atomic>
+#include <iostream>
+#include <exception>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+
+using namespace H5;
+
+template<typename ValueType> static void
+writeAttribute(H5Object &object, const char *name, const PredType &type, const ValueType &value) {
+    Attribute attribute = object.createAttribute(name, type, DataSpace(H5S_SCALAR));
+    attribute.write(type, &value);
+}
+
+static void writeAttribute(H5Object &object, const char *name, const std::string &value) {
+    // h5py stores python bytes as fixed length strings
+    StrType type(PredType::C_S1, std::max<std::size_t>(value.size(), 1));
+    Attribute attribute = object.createAttribute(name, type, DataSpace(H5S_SCALAR));
+    attribute.write(type, value);
+}
+
+unsigned int MEDALHdf5Converter::convertFiles(const std::vector<std::string> &input_files) {
+    std::atomic<std::size_t> next_file(0);
+    std::atomic<unsigned int> failed_files(0);
+    auto worker = [&]() {
+        for (std::size_t i = next_file++; i < input_files.size(); i = next_file++) {
+            try {
+                std::string output_file = this->convertFile(input_files[i]);
+                std::lock_guard<std::mutex> lock(this->hdf5_mutex);
+                std::cout << "Converted " << input_files[i] << " to " << output_file << std::endl;
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(this->hdf5_mutex);
+                std::cerr << "Converting " << input_files[i] << " failed" << std::endl;
+                ++failed_files;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    unsigned int number_of_workers = std::min<std::size_t>(std::max(this->number_of_threads, 1u), input_files.size());
+    for (unsigned int i = 1; i < number_of_workers; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread: workers) {
+        thread.join();
+    }
+    return failed_files;
+}
+
+std::string MEDALHdf5Converter::convertFile(const std::string &input_file) {
+    boost::filesystem::path input_path(input_file);
+    std::string output_file = (boost::filesystem::path(this->output_directory) /
+                               input_path.stem()).string() + ".hdf5";
+    DecodedCapture capture = this->decodeCapture(input_file);
+    {
+        std::lock_guard<std::mutex> lock(this->hdf5_mutex);
+        if (capture.trigger_id_gaps > 0) {
+            std::cerr << "Found " << capture.trigger_id_gaps << " gaps in the trigger ids of " << input_file << std::endl;
+        }
+        this->writeCapture(capture, output_file + ".inprogress");
+    }
+    boost::filesystem::rename(output_file + ".inprogress", output_file);
+    if (this->remove_input_files) {
+        boost::filesystem::remove(input_path);
+    }
+    return output_file;
+}
+
+MEDALHdf5Converter::CaptureName MEDALHdf5Converter::parseCaptureName(const std::string &input_file) {
+    // unit-2016-06-04T22-24-42.411571+0200-0000001.bin
+    static const std::regex capture_name_expression(
+            "^(.+)-(\\d{4})-(\\d{2})-(\\d{2})T(\\d{2})-(\\d{2})-(\\d{2})\\.(\\d+)(.+)-(\\d+)\\.bin$");
+    std::string file_name = boost::filesystem::path(input_file).filename().string();
+    std::smatch match;
+    if (!std::regex_match(file_name, match, capture_name_expression)) {
+        std::cerr << "File name not matched: " << file_name << std::endl;
+        throw std::exception();
+    }
+
+    CaptureName capture_name;
+    capture_name.name = match[1];
+    capture_name.year = std::stoul(match[2]);
+    capture_name.month = std::stoul(match[3]);
+    capture_name.day = std::stoul(match[4]);
+    capture_name.hours = std::stoul(match[5]);
+    capture_name.minutes = std::stoul(match[6]);
+    capture_name.seconds = std::stoul(match[7]);
+    capture_name.microseconds = std::stoul(match[8]);
+    capture_name.timezone = match[9];
+    capture_name.sequence = std::stoull(match[10]);
+    return capture_name;
+}
+
+MEDALHdf5Converter::DecodedCapture MEDALHdf5Converter::decodeCapture(const std::string &input_file) {
+    DecodedCapture capture;
+    capture.capture_name = parseCaptureName(input_file);
+
+    MappedFile mapped_file(input_file);
+    mapped_file.adviseSequential();
+    capture.number_of_samples = mapped_file.size() / MEDALPacket::packet_length;
+    if (mapped_file.size() % MEDALPacket::packet_length != 0) {
+        std::cerr << "Last packet in file incomplete in file: " << input_file << std::endl;
+    }
+    if (capture.number_of_samples == 0) {
+        std::cerr << "No complete packet in file: " << input_file << std::endl;
+        throw std::exception();
+    }
+
+    for (auto &channel: capture.channels) {
+        channel.resize(capture.number_of_samples);
+    }
+    const uint8_t *packets = reinterpret_cast<const uint8_t *>(mapped_file.data());
+    capture.first_trigger_id = MEDALPacket::triggerId(packets);
+    uint16_t previous_trigger_id = static_cast<uint16_t>(capture.first_trigger_id - 1);
+    for (hsize_t i = 0; i < capture.number_of_samples; ++i) {
+        uint16_t trigger_id = MEDALPacket::triggerId(packets + i * MEDALPacket::packet_length);
+        if (!MEDALPacket::isNextTriggerId(previous_trigger_id, trigger_id)) {
+            ++capture.trigger_id_gaps;
+        }
+        previous_trigger_id = trigger_id;
+    }
+    capture.last_trigger_id = previous_trigger_id;
+
+    // the raw values are decoded in place and shifted to signed values afterwards
+    uint16_t *channels[MEDALPacket::number_of_channels];
+    for (unsigned int channel = 0; channel < MEDALPacket::number_of_channels; ++channel) {
+        channels[channel] = reinterpret_cast<uint16_t *>(capture.channels[channel].data());
+    }
+    MEDALPacket::decodePackets(packets, capture.number_of_samples, channels);
+    for (unsigned int channel = 0; channel < MEDALPacket::number_of_currents; ++channel) {
+        for (auto &sample: capture.channels[channel]) {
+            sample = static_cast<int16_t>(sample - MEDALPacket::current_offset);
+        }
+    }
+    double voltage_sum = 0;
+    for (auto sample: capture.channels[MEDALPacket::voltage_channel]) {
+        voltage_sum += sample;
+    }
+
+    // like converter.py the integral part of the mean is removed from the samples
+    capture.mean_voltage = voltage_sum / capture.number_of_samples;
+    int16_t removed_voltage_offset = static_cast<int16_t>(capture.mean_voltage);
+    for (auto &sample: capture.channels[MEDALPacket::voltage_channel]) {
+        sample -= removed_voltage_offset;
+    }
+    return capture;
+}
+
+void MEDALHdf5Converter::writeCapture(const DecodedCapture &capture, const std::string &output_file) {
+    H5File file(output_file, H5F_ACC_TRUNC);
+    Group root = file.openGroup("/");
+
+    const CaptureName &capture_name = capture.capture_name;
+    writeAttribute(root, "name", capture_name.name);
+    writeAttribute(root, "year", PredType::NATIVE_UINT32, capture_name.year);
+    writeAttribute(root, "month", PredType::NATIVE_UINT32, capture_name.month);
+    writeAttribute(root, "day", PredType::NATIVE_UINT32, capture_name.day);
+    writeAttribute(root, "hours", PredType::NATIVE_UINT32, capture_name.hours);
+    writeAttribute(root, "minutes", PredType::NATIVE_UINT32, capture_name.minutes);
+    writeAttribute(root, "seconds", PredType::NATIVE_UINT32, capture_name.seconds);
+    writeAttribute(root, "microseconds", PredType::NATIVE_UINT32, capture_name.microseconds);
+    writeAttribute(root, "sequence", PredType::NATIVE_UINT64, capture_name.sequence);
+    writeAttribute(root, "timezone", capture_name.timezone);
+    writeAttribute(root, "frequency", PredType::NATIVE_UINT64, this->frequency);
+    writeAttribute(root, "first_trigger_id", PredType::NATIVE_UINT16, capture.first_trigger_id);
+    writeAttribute(root, "last_trigger_id", PredType::NATIVE_UINT16, capture.last_trigger_id);
+
+    for (unsigned int channel = 0; channel < MEDALPacket::number_of_currents; ++channel) {
+        std::string name = "current" + std::to_string(channel + 1);
+        this->writeChannel(file, name, capture.channels[channel]);
+        DataSet dataset = file.openDataSet(name);
+        writeAttribute(dataset, "calibration_factor", PredType::NATIVE_DOUBLE, MEDALPacket::calibrationFactor(channel));
+        writeAttribute(dataset, "removed_offset", PredType::NATIVE_UINT16,
+                       static_cast<uint16_t>(MEDALPacket::current_offset));
+    }
+    this->writeChannel(file, "voltage", capture.channels[MEDALPacket::voltage_channel]);
+    DataSet voltage_dataset = file.openDataSet("voltage");
+    writeAttribute(voltage_dataset, "calibration_factor", PredType::NATIVE_DOUBLE,
+                   MEDALPacket::calibrationFactor(MEDALPacket::voltage_channel));
+    writeAttribute(voltage_dataset, "removed_offset", PredType::NATIVE_DOUBLE, capture.mean_voltage);
+}
+
+void MEDALHdf5Converter::writeChannel(H5File &file, const std::string &name, const std::vector<int16_t> &samples) {
+    hsize_t dimensions[1] = {samples.size()};
+    DataSpace dataspace(1, dimensions);
+
+    DSetCreatPropList properties;
+    hsize_t chunk_dimensions[1] = {std::min<hsize_t>(std::max<hsize_t>(this->chunk_size, 1), samples.size())};
+    properties.setChunk(1, chunk_dimensions);
+    properties.setFletcher32();
+    properties.setShuffle();
+    if (this->compression_level > 0) {
+        properties.setDeflate(std::min(this->compression_level, 9u));
+    }
+
+    DataSet dataset = file.createDataSet(name, PredType::STD_I16LE, dataspace, properties);
+    dataset.write(samples.data(), PredType::NATIVE_INT16);
+}
@@ -0,0 +1,72 @@
+#ifndef MEDALHDF5CONVERTER_H
+#define MEDALHDF5CONVERTER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include "H5Cpp.h"
+
+#include "MEDALPacket.h"
+
+/**
+ * @brief Converts the raw .bin captures of energy_daq to HDF5 files with the layout of energy_daq/src/converter.py.
+ *
+ * Every output file holds the int16 data sets current1 to current6 and voltage with their calibration_factor and
+ * removed_offset, and the attributes parsed from the name of the capture. Several files are decoded at once, the HDF5
+ * library is only entered by one thread at a time.
+ */
+class MEDALHdf5Converter {
+public:
+    /**
+     * @brief Converts all files and returns the number of files that could not be converted.
+     */
+    unsigned int convertFiles(const std::vector<std::string> &input_files);
+
+    /**
+     * @brief Converts one capture and returns the path of the HDF5 file.
+     */
+    std::string convertFile(const std::string &input_file);
+
+public:
+    std::string output_directory = ".";
+    /**
+     * @brief Sample rate of the captures, stored in the frequency attribute.
+     */
+    uint64_t frequency = 6400;
+    unsigned int number_of_threads = 1;
+    hsize_t chunk_size = 1 << 15;
+    unsigned int compression_level = 9;
+    bool remove_input_files = false;
+
+private:
+    struct CaptureName {
+        std::string name;
+        uint32_t year, month, day, hours, minutes, seconds, microseconds;
+        std::string timezone;
+        uint64_t sequence;
+    };
+
+    struct DecodedCapture {
+        CaptureName capture_name;
+        hsize_t number_of_samples = 0;
+        uint16_t first_trigger_id = 0;
+        uint16_t last_trigger_id = 0;
+        unsigned long trigger_id_gaps = 0;
+        double mean_voltage = 0;
+        std::vector<int16_t> channels[MEDALPacket::number_of_channels];
+    };
+
+    static CaptureName parseCaptureName(const std::string &input_file);
+
+    DecodedCapture decodeCapture(const std::string &input_file);
+
+    void writeCapture(const DecodedCapture &capture, const std::string &output_file);
+
+    void writeChannel(H5::H5File &file, const std::string &name, const std::vector<int16_t> &samples);
+
+private:
+    std::mutex hdf5_mutex;
+};
+
+#endif // MEDALHDF5CONVERTER_H
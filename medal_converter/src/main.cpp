@@ -0,0 +1,28 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include "MEDALHdf5Converter.h"
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        std::cout << "usage: medal_converter <frequency> <output directory> <raw files>... [--remove-input]\n";
+        std::cout << "Converts the .bin captures of energy_daq to HDF5 files. With --remove-input the converted captures are deleted.\n";
+        return -1;
+    }
+    MEDALHdf5Converter converter;
+    converter.frequency = std::stoull(argv[1]);
+    converter.output_directory = argv[2];
+    converter.number_of_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::vector<std::string> input_files;
+    for (int i = 3; i < argc; ++i) {
+        if (std::string(argv[i]) == "--remove-input") {
+            converter.remove_input_files = true;
+        } else {
+            input_files.push_back(argv[i]);
+        }
+    }
+    return converter.convertFiles(input_files) == 0 ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include <Event.h>
+#include <MEDALDataPoint.h>
+#include <FeatureExtractor.h>
+
+// an event whose channels carry loads of different size, like a MEDAL event that was detected on two channels
+static Event<MEDALDataPoint> testEvent() {
+    Event<MEDALDataPoint> event;
+    event.event_meta_data.power_meta_data.sample_rate = 12000;
+    event.event_meta_data.power_meta_data.frequency = 60;
+    event.event_meta_data.power_meta_data.data_points_stored_before_event = 2000;
+    event.event_meta_data.power_meta_data.data_points_stored_of_event = 4000;
+
+    event.event_data.resize(6000);
+    for (unsigned long i = 0; i < event.event_data.size(); ++i) {
+        const float phase = static_cast<float>(2 * M_PI * i / 200.0);
+        const bool switched_on = i >= 2000;
+        MEDALDataPoint &data_point = event.event_data[i];
+        data_point.volts = 170.0f * std::sin(phase);
+        for (unsigned int channel = 0; channel < MEDALDataPoint::number_of_channels; ++channel) {
+            data_point.currents[channel] = 0.1f * std::sin(phase);
+        }
+        if (switched_on) {
+            data_point.currents[1] += 2.0f * std::sin(phase);
+            data_point.currents[4] += 6.0f * std::sin(phase - 0.5f) + 1.0f * std::sin(3 * phase);
+        }
+    }
+    return event;
+}
+
+static bool sameFeatures(const EventFeatures &first, const EventFeatures &second) {
+    if (first.feature_vector.size() != second.feature_vector.size()) {
+        return false;
+    }
+    for (unsigned long i = 0; i < first.feature_vector.size(); ++i) {
+        if (std::abs(first.feature_vector[i] - second.feature_vector[i]) > 1e-4f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    Event<MEDALDataPoint> event = testEvent();
+    FeatureExtractor feature_extractor;
+    feature_extractor.setConfig(ClassificationConfig());
+
+    // the EventDetector stores a copy of the event for every channel the event was detected on
+    Event<MEDALDataPoint> first_channel_event = event;
+    first_channel_event.event_meta_data.channel = 1;
+    Event<MEDALDataPoint> second_channel_event = event;
+    second_channel_event.event_meta_data.channel = 4;
+
+    const EventFeatures first_channel_features = feature_extractor.extractFeatures(first_channel_event);
+    const EventFeatures second_channel_features = feature_extractor.extractFeatures(second_channel_event);
+    const EventFeatures sum_features = feature_extractor.extractFeatures(event);
+
+    bool success = true;
+    if (first_channel_features.feature_vector.empty()) {
+        std::cerr << "no features were extracted" << std::endl;
+        success = false;
+    }
+    if (sameFeatures(first_channel_features, second_channel_features)) {
+        std::cerr << "the events of channel 1 and channel 4 have the same features" << std::endl;
+        success = false;
+    }
+    if (sameFeatures(first_channel_features, sum_features) || sameFeatures(second_channel_features, sum_features)) {
+        std::cerr << "the event of a single channel has the features of the sum of all channels" << std::endl;
+        success = false;
+    }
+
+    // the RMS step of the channel is the first RMS feature, after the phase shift
+    const float expected_rms_step = 2.0f / std::sqrt(2.0f);
+    if (std::abs(first_channel_features.feature_vector[1] - expected_rms_step) > 0.05f) {
+        std::cerr << "expected an RMS step of " << expected_rms_step << " on channel 1, got "
+                  << first_channel_features.feature_vector[1] << std::endl;
+        success = false;
+    }
+    return success ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <vector>
+
+#define DONT_STORE_ANYTHING
+
+#include <PowerMetaData.h>
+#include <DynamicStreamMetaData.h>
+#include <DefaultDataPoint.h>
+#include <DefaultEventDetectionStrategy.h>
+#include <SlidingWindowEventDetectionStrategy.h>
+#include <EventDetector.h>
+
+// the current steps from 1 A to 3 A at the start of the period beginning with this data point
+static const unsigned long step_data_point = 1000;
+
+static PowerMetaData testMetaData() {
+    PowerMetaData conf;
+    conf.sample_rate = 12000;
+    conf.frequency = 60;
+    conf.max_data_points_in_queue = 16000;
+    conf.data_points_stored_before_event = 400;
+    conf.data_points_stored_of_event = 800;
+    return conf;
+}
+
+template<typename StrategyType> std::vector<Event<DefaultDataPoint>> detectEvents(StrategyType strategy) {
+    const PowerMetaData conf = testMetaData();
+    DynamicStreamMetaData meta_data;
+    meta_data.setFixedPowerMetaData(conf);
+    const DynamicStreamMetaData::TimeType start(boost::gregorian::date(2020, 1, 1));
+    meta_data.syncTimePoint(0, start);
+
+    std::vector<DefaultDataPoint> data_points(4000);
+    for (unsigned long i = 0; i < data_points.size(); ++i) {
+        data_points[i] = DefaultDataPoint(0.0f, i < step_data_point ? 1.0f : 3.0f);
+    }
+
+    AsyncDataQueue<DefaultDataPoint> queue;
+    queue.setQueueMaxSize(conf.max_data_points_in_queue);
+    std::vector<Event<DefaultDataPoint>> events;
+    EventDetector<StrategyType> detector;
+    detector.storage.setEventStorageCallback([&events](Event<DefaultDataPoint> &event) {
+        events.push_back(event);
+    });
+    detector.startAnalyzing(&queue, &meta_data, strategy);
+    queue.addDataPoints(data_points.begin(), data_points.end());
+    queue.notifyStreamEnd();
+    detector.join();
+    return events;
+}
+
+static bool checkEventTime(const std::string &name, const std::vector<Event<DefaultDataPoint>> &events,
+                           unsigned long expected_data_point) {
+    const DynamicStreamMetaData::TimeType start(boost::gregorian::date(2020, 1, 1));
+    // 12 kHz, so every 12 data points are exactly one millisecond
+    const DynamicStreamMetaData::TimeType expected = start + boost::posix_time::milliseconds(expected_data_point / 12);
+    if (events.size() != 1) {
+        std::cerr << name << ": expected one event, got " << events.size() << std::endl;
+        return false;
+    }
+    if (events.front().event_meta_data.event_time != expected) {
+        std::cerr << name << ": expected the event at " << expected << ", got "
+                  << events.front().event_meta_data.event_time << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool success = true;
+
+    // the period 1000..1199 is the first one with the higher RMS, its end is reported
+    success &= checkEventTime("default strategy", detectEvents(DefaultEventDetectionStrategy(0.5f)),
+                              step_data_point + 200);
+
+    // a window of 200 samples exceeds an RMS of 1.5 once 32 of them are 3 A, the window ends with data point 1031
+    success &= checkEventTime("sliding window strategy", detectEvents(SlidingWindowEventDetectionStrategy(0.5f, 1)),
+                              step_data_point + 32);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <utility>
+
+#include <IncrementalNearestNeighbourIndex.h>
+
+// the kd-tree of libnabo together with the brute force tail has to find the same neighbours as a search over all points
+static bool checkQuery(const IncrementalNearestNeighbourIndex &index, const Eigen::VectorXf &query, unsigned long k) {
+    auto points = index.points();
+    std::vector<std::pair<float, int>> expected;
+    for (long i = 0; i < points.cols(); ++i) {
+        float dist2 = (points.col(i) - query).squaredNorm();
+        if (dist2 > 0) {
+            expected.emplace_back(dist2, static_cast<int>(i));
+        }
+    }
+    std::sort(expected.begin(), expected.end());
+    expected.resize(std::min<std::size_t>(k, expected.size()));
+
+    IncrementalNearestNeighbourIndex::IndexVectorType indices;
+    IncrementalNearestNeighbourIndex::VectorType dists2;
+    const unsigned long found = index.knn(query, indices, dists2, k);
+    if (found != expected.size()) {
+        std::cerr << "expected " << expected.size() << " neighbours, found " << found << std::endl;
+        return false;
+    }
+    for (unsigned long i = 0; i < found; ++i) {
+        if (indices(i) != expected[i].second) {
+            std::cerr << "neighbour " << i << " of " << index.size() << " points: expected point " << expected[i].second
+                      << ", found point " << indices(i) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    std::mt19937 mt(42);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    const long dimensions = 7;
+
+    IncrementalNearestNeighbourIndex index;
+    bool success = true;
+    for (unsigned long i = 0; i < 1000 && success; ++i) {
+        Eigen::VectorXf point(dimensions);
+        for (long d = 0; d < dimensions; ++d) {
+            point(d) = distribution(mt);
+        }
+        index.insert(point);
+        if (index.needsRebuild()) {
+            index.rebuild();
+        }
+
+        if (i % 37 == 0) {
+            Eigen::VectorXf query(dimensions);
+            for (long d = 0; d < dimensions; ++d) {
+                query(d) = distribution(mt);
+            }
+            success &= checkQuery(index, query, 5);
+            // a query at a stored point does not return the point itself
+            success &= checkQuery(index, index.points().col(i / 2), 3);
+        }
+    }
+    if (index.indexedSize() == 0 || index.unindexedSize() == index.size()) {
+        std::cerr << "the kd-tree was never built" << std::endl;
+        success = false;
+    }
+    return success ? 0 : 1;
+}
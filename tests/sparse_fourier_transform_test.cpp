@@ -0,0 +1,48 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include <SparseFourierTransformCalculator.h>
+
+// every bin of the Goertzel passes is compared to a directly evaluated DFT, the bin counts are no multiple of the pass size
+static bool checkBins(const std::vector<float> &signal, const std::vector<unsigned long> &bins) {
+    SparseFourierTransformCalculator calculator;
+    std::vector<kiss_fft_cpx> result;
+    calculator.calculateBins(signal.begin(), signal.end(), bins, result);
+    if (result.size() != bins.size()) {
+        std::cerr << "expected " << bins.size() << " bins, got " << result.size() << std::endl;
+        return false;
+    }
+
+    const double N = signal.size();
+    bool success = true;
+    for (unsigned long b = 0; b < bins.size(); ++b) {
+        double real = 0;
+        double imaginary = 0;
+        for (unsigned long n = 0; n < signal.size(); ++n) {
+            real += signal[n] * std::cos(2.0 * M_PI * bins[b] * n / N);
+            imaginary -= signal[n] * std::sin(2.0 * M_PI * bins[b] * n / N);
+        }
+        if (std::abs(result[b].r - real) > 1e-2 || std::abs(result[b].i - imaginary) > 1e-2) {
+            std::cerr << "bin " << bins[b] << " of " << bins.size() << ": expected (" << real << ", " << imaginary
+                      << "), got (" << result[b].r << ", " << result[b].i << ")" << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+int main() {
+    std::vector<float> signal(200);
+    for (unsigned long n = 0; n < signal.size(); ++n) {
+        signal[n] = 3.0f * std::sin(2.0 * M_PI * n / 200.0) + 0.5f * std::cos(2.0 * M_PI * 3 * n / 200.0) +
+                    0.1f * static_cast<float>(n % 7);
+    }
+
+    bool success = true;
+    success &= checkBins(signal, {1});
+    success &= checkBins(signal, {1, 3, 5});
+    success &= checkBins(signal, {0, 1, 2, 3, 4, 5, 6});
+    success &= checkBins(signal, {1, 3, 5, 7, 9});
+    return success ? 0 : 1;
+}